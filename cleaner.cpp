@@ -4,6 +4,20 @@
 #include <set>
 #include <sstream>
 #include <iostream>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <cctype>
+#include <cstring>
+#include <chrono>
 
 // Cross-platform filesystem implementation
 #ifdef _WIN32
@@ -16,7 +30,18 @@
     #include <sys/stat.h>
     #include <dirent.h>
     #include <unistd.h>
-    #include <cstring>  // Added for strcmp function
+    #include <fcntl.h>
+    #include <cerrno>
+    #include <cstdio>
+    #include <sys/file.h>
+    #include <sys/wait.h>
+    #include <sys/syscall.h>
+    #include <sys/ioctl.h>
+    #include <sys/resource.h>
+    #include <sched.h>
+#ifdef __linux__
+    #include <linux/fs.h>
+#endif
     #define GetCurrentDir getcwd
 #endif
 
@@ -113,10 +138,116 @@ namespace fs {
             return DeleteFileA(p.string().c_str()) != 0;
         }
 #else
-        return remove(p.string().c_str()) == 0;
+        return ::remove(p.string().c_str()) == 0;
 #endif
     }
 
+#ifndef _WIN32
+    // Directory streams kept open while deleting a tree. Levels below the window are
+    // closed and reopened relative to the tree root when the walk climbs back to them.
+    const size_t kMaxOpenDirs = 32;
+
+    // Deletes `p` and everything below it without spawning processes or following
+    // symlinks. Entries are removed through their parent's fd (unlinkat), so path
+    // length and special characters in names do not matter.
+    inline bool remove_tree(const path& p) {
+        struct stat info;
+        if (lstat(p.string().c_str(), &info) != 0) return errno == ENOENT;
+        if (!S_ISDIR(info.st_mode)) return unlink(p.string().c_str()) == 0;
+
+        const int flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+        int base = open(p.string().c_str(), flags);
+        if (base < 0) return false;
+
+        struct Frame {
+            DIR* dir;
+            std::string name;
+            std::set<std::string> failed; // entries not to retry after a reopen
+        };
+        std::vector<Frame> stack;
+        size_t open_dirs = 0;
+        bool ok = true;
+
+        auto open_frame = [&](int fd, size_t index) {
+            if (open_dirs == kMaxOpenDirs) {
+                for (auto& f : stack) {
+                    if (!f.dir) continue;
+                    closedir(f.dir);
+                    f.dir = nullptr;
+                    open_dirs--;
+                    break;
+                }
+            }
+            stack[index].dir = fdopendir(fd);
+            if (!stack[index].dir) {
+                close(fd);
+                return false;
+            }
+            open_dirs++;
+            return true;
+        };
+        auto reopen = [&](size_t index) {
+            std::string rel = ".";
+            for (size_t i = 1; i <= index; ++i) rel += "/" + stack[i].name;
+            int fd = openat(base, rel.c_str(), flags);
+            return fd >= 0 && open_frame(fd, index);
+        };
+
+        stack.push_back({nullptr, "", {}});
+        if (!reopen(0)) stack.clear();
+        while (!stack.empty()) {
+            size_t top = stack.size() - 1;
+            if (!stack[top].dir && !reopen(top)) {
+                ok = false;
+                stack.pop_back();
+                continue;
+            }
+            DIR* dir = stack[top].dir;
+            struct dirent* entry = readdir(dir);
+            if (!entry) {
+                closedir(dir);
+                open_dirs--;
+                std::string name = stack[top].name;
+                stack.pop_back();
+                if (stack.empty()) break;
+                Frame& parent = stack.back();
+                if ((!parent.dir && !reopen(stack.size() - 1)) || unlinkat(dirfd(parent.dir), name.c_str(), AT_REMOVEDIR) != 0) {
+                    ok = false;
+                    parent.failed.insert(name);
+                }
+                continue;
+            }
+            const char* name = entry->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0 || stack[top].failed.count(name)) continue;
+
+            bool is_dir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN) {
+                is_dir = fstatat(dirfd(dir), name, &info, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(info.st_mode);
+            }
+            if (!is_dir) {
+                if (unlinkat(dirfd(dir), name, 0) != 0 && errno != ENOENT) {
+                    ok = false;
+                    stack[top].failed.insert(name);
+                }
+                continue;
+            }
+            int fd = openat(dirfd(dir), name, flags);
+            if (fd >= 0) {
+                stack.push_back({nullptr, name, {}});
+                if (open_frame(fd, stack.size() - 1)) continue;
+                stack.pop_back();
+            }
+            ok = false;
+            stack[top].failed.insert(name);
+        }
+        for (auto& f : stack) {
+            if (f.dir) closedir(f.dir);
+        }
+        close(base);
+        return rmdir(p.string().c_str()) == 0 && ok;
+    }
+#endif
+
     inline bool remove_all(const path& p) {
 #ifdef _WIN32
         if (is_directory(p)) {
@@ -152,9 +283,7 @@ namespace fs {
             return result == 0;
         }
 #else
-        std::string cmd = "rm -rf \"" + p.string() + "\"";
-        int result = system(cmd.c_str());
-        return result == 0;
+        return remove_tree(p);
 #endif
     }
 
@@ -166,118 +295,719 @@ namespace fs {
         return path("");
     }
 
-    // Directory iterator - simplified implementation
+    inline bool rename(const path& from, const path& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.string().c_str(), to.string().c_str(), 0) != 0;
+#else
+        return ::rename(from.string().c_str(), to.string().c_str()) == 0;
+#endif
+    }
+
+    // Creates `p` and any missing parent folders.
+    inline bool create_directories(const path& p) {
+        const std::string& s = p.string();
+        for (size_t i = 1; i <= s.size(); ++i) {
+            if (i < s.size() && s[i] != '/' && s[i] != '\\') continue;
+            std::string prefix = s.substr(0, i);
+#ifdef _WIN32
+            CreateDirectoryA(prefix.c_str(), nullptr);
+#else
+            mkdir(prefix.c_str(), 0777);
+#endif
+        }
+        return is_directory(p);
+    }
+
+    enum class file_type { not_found, regular, directory };
+
+    // Type of `p` itself; a symlink (or junction) to a directory is not a directory.
+    inline file_type symlink_status(const path& p) {
+#ifdef _WIN32
+        DWORD attributes = GetFileAttributesA(p.string().c_str());
+        if (attributes == INVALID_FILE_ATTRIBUTES) return file_type::not_found;
+        bool dir = (attributes & FILE_ATTRIBUTE_DIRECTORY) && !(attributes & FILE_ATTRIBUTE_REPARSE_POINT);
+#else
+        struct stat info;
+        if (lstat(p.string().c_str(), &info) != 0) return file_type::not_found;
+        bool dir = S_ISDIR(info.st_mode);
+#endif
+        return dir ? file_type::directory : file_type::regular;
+    }
+
+    // Streams the entries of one directory, skipping "." and "..". An entry is the name
+    // as returned by readdir/FindNextFile plus its type (d_type); a stat is only made,
+    // relative to the open directory, on file systems that report DT_UNKNOWN. Full paths
+    // are built only when get_path() is called.
     class directory_iterator {
     public:
-        struct directory_entry {
-            path p;
-            directory_entry(const path& path) : p(path) {}
-            const path& get_path() const { return p; }  // Changed name to avoid conflict
+        class directory_entry {
+        public:
+            const char* name() const { return name_; }
+
+            // Type of the entry itself; links are never followed.
+            file_type type() const {
+#ifndef _WIN32
+                if (type_ == file_type::not_found) {
+                    struct stat info;
+                    type_ = fstatat(dirfd(owner_->dir), name_, &info, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(info.st_mode)
+                                ? file_type::directory
+                                : file_type::regular;
+                }
+#endif
+                return type_;
+            }
+
+            path get_path() const { return owner_->base / name_; }
+
+        private:
+            friend class directory_iterator;
+            const directory_iterator* owner_ = nullptr;
+            const char* name_ = "";
+            mutable file_type type_ = file_type::not_found; // not_found: not known yet
         };
-        
-    private:
-        std::vector<directory_entry> entries;
-        size_t index;
-        bool valid;
-        
-    public:
-        directory_iterator(const path& p) : index(0), valid(true) {
+
+        directory_iterator() {}
+
+        explicit directory_iterator(const path& p) : base(p) {
 #ifdef _WIN32
-            WIN32_FIND_DATAA findData;
-            HANDLE hFind = FindFirstFileA((p.string() + "\\*").c_str(), &findData);
-            if (hFind != INVALID_HANDLE_VALUE) {
-                do {
-                    if (strcmp(findData.cFileName, ".") != 0 && 
-                        strcmp(findData.cFileName, "..") != 0) {
-                        entries.push_back(directory_entry(p / findData.cFileName));
-                    }
-                } while (FindNextFileA(hFind, &findData));
-                
-                FindClose(hFind);
-            }
+            find = FindFirstFileA((p.string() + "\\*").c_str(), &findData);
+            valid = find != INVALID_HANDLE_VALUE;
+            if (valid) settle();
 #else
-            DIR* dir = opendir(p.string().c_str());
-            if (dir != nullptr) {
-                struct dirent* entry;
-                while ((entry = readdir(dir)) != nullptr) {
-                    if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
-                        entries.push_back(directory_entry(p / entry->d_name));
-                    }
-                }
-                closedir(dir);
-            }
+            dir = opendir(p.string().c_str());
+            advance();
 #endif
         }
-        
-        directory_iterator() : index(0), valid(false) {}
-        
-        directory_entry& operator*() {
-            return entries[index];
+
+#ifndef _WIN32
+        // Takes over an already open directory fd, e.g. one opened with O_NOFOLLOW.
+        directory_iterator(int fd, const path& p) : base(p) {
+            dir = fdopendir(fd);
+            if (!dir) ::close(fd);
+            advance();
         }
-        
+
+        int fd() const { return dir ? dirfd(dir) : -1; }
+#endif
+
+        bool is_open() const {
+#ifdef _WIN32
+            return find != INVALID_HANDLE_VALUE;
+#else
+            return dir != nullptr;
+#endif
+        }
+
+        directory_iterator(const directory_iterator&) = delete;
+        directory_iterator& operator=(const directory_iterator&) = delete;
+
+        ~directory_iterator() {
+#ifdef _WIN32
+            if (find != INVALID_HANDLE_VALUE) FindClose(find);
+#else
+            if (dir) closedir(dir);
+#endif
+        }
+
+        const directory_entry& operator*() const { return entry; }
+        const directory_entry* operator->() const { return &entry; }
+
         directory_iterator& operator++() {
-            ++index;
-            if (index >= entries.size()) {
-                valid = false;
-            }
+#ifdef _WIN32
+            valid = FindNextFileA(find, &findData) != 0;
+            if (valid) settle();
+#else
+            advance();
+#endif
             return *this;
         }
-        
+
         bool operator!=(const directory_iterator& other) const {
             return valid != other.valid;
         }
+
+    private:
+#ifdef _WIN32
+        // Moves past "." and ".." and fills in the entry.
+        void settle() {
+            while (valid && (strcmp(findData.cFileName, ".") == 0 || strcmp(findData.cFileName, "..") == 0)) {
+                valid = FindNextFileA(find, &findData) != 0;
+            }
+            if (!valid) return;
+            entry.owner_ = this;
+            entry.name_ = findData.cFileName;
+            bool isDir = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+                         !(findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT);
+            entry.type_ = isDir ? file_type::directory : file_type::regular;
+        }
+
+        HANDLE find = INVALID_HANDLE_VALUE;
+        WIN32_FIND_DATAA findData;
+#else
+        void advance() {
+            valid = false;
+            if (!dir) return;
+            while (struct dirent* e = readdir(dir)) {
+                if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+                entry.owner_ = this;
+                entry.name_ = e->d_name;
+                entry.type_ = e->d_type == DT_UNKNOWN ? file_type::not_found
+                            : e->d_type == DT_DIR    ? file_type::directory
+                                                     : file_type::regular;
+                valid = true;
+                return;
+            }
+        }
+
+        DIR* dir = nullptr;
+#endif
+        path base = path("");
+        directory_entry entry;
+        bool valid = false;
     };
+
+    // Calls `fn(name, type)` for every entry of `p` without following links. False if
+    // `p` could not be opened.
+    template <typename Fn>
+    bool for_each_entry(const path& p, Fn fn) {
+        directory_iterator it(p);
+        for (directory_iterator end; it != end; ++it) fn(std::string(it->name()), it->type());
+        return it.is_open();
+    }
 }
 
-void delete_with_exceptions(const fs::path& p, const std::set<std::string>& exceptions) {
-    if (!fs::exists(p)) return;
+// Shared by all workers: up to one second's worth of burst, then `rate` per second. A
+// taker that overdraws sleeps off its own part of the debt, so concurrent takers line
+// up in time instead of spinning.
+class TokenBucket {
+public:
+    explicit TokenBucket(double rate) : rate(rate), tokens(rate), last(std::chrono::steady_clock::now()) {}
+
+    // Returns how long the caller was held back.
+    std::chrono::nanoseconds take(double n) {
+        std::chrono::nanoseconds wait(0);
+        {
+            std::lock_guard<std::mutex> lock(m);
+            auto now = std::chrono::steady_clock::now();
+            tokens = std::min(rate, tokens + rate * std::chrono::duration<double>(now - last).count());
+            last = now;
+            tokens -= n;
+            if (tokens < 0) {
+                wait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(-tokens / rate));
+            }
+        }
+        if (wait.count() > 0) std::this_thread::sleep_for(wait);
+        return wait;
+    }
+
+private:
+    std::mutex m;
+    double rate;
+    double tokens;
+    std::chrono::steady_clock::time_point last;
+};
+
+// Deletes trees on a fixed set of workers. Every directory is one task: the worker
+// unlinks its files and queues its subdirectories, and a directory is removed as soon
+// as its last subdirectory is gone. Workers take their own newest task (depth-first,
+// so queues stay short) and steal the oldest, shallowest task of another worker when
+// they run dry. The same pool also walks trees without touching them: to measure them
+// (--plan) and to look for .meta files out of step with their assets (--orphans).
+class ParallelDeleter {
+public:
+    // Completion handle for a group of queued removals.
+    struct Batch {
+        std::mutex m;
+        std::condition_variable done;
+        size_t pending = 0;
+        bool ok = true;
+    };
+
+    // What removing the trees queued with measure() would delete.
+    struct Usage {
+        std::atomic<uint64_t> files{0};
+        std::atomic<uint64_t> directories{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> allocated{0}; // bytes on disk, directories included
+        std::atomic<int64_t> newest{0};     // latest access or modification, Unix seconds
+
+        void add(bool dir, uint64_t size, uint64_t onDisk, int64_t used) {
+            if (dir) {
+                directories++;
+            } else {
+                files++;
+                bytes += size;
+            }
+            allocated += onDisk;
+            int64_t seen = newest.load();
+            while (used > seen && !newest.compare_exchange_weak(seen, used)) {}
+        }
+    };
+
+    // Deletions done under limit() and the time workers spent waiting for the limits.
+    struct Throttling {
+        uint64_t unlinks;
+        uint64_t bytes;
+        uint64_t waits;
+        double seconds;
+    };
+
+    // Found by scan_orphans(): .meta files whose asset is gone, and assets Unity would
+    // import that have no .meta yet.
+    struct Orphans {
+        std::mutex m;
+        std::vector<std::string> metas;
+        std::vector<std::string> assets;
+    };
+
+    explicit ParallelDeleter(unsigned jobs) {
+        if (jobs == 0) jobs = 1;
+        for (unsigned i = 0; i < jobs; ++i) queues.emplace_back(new Queue());
+        for (unsigned i = 0; i < jobs; ++i) workers.emplace_back([this, i]() { run(i); });
+    }
+
+    ~ParallelDeleter() {
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            stop = true;
+        }
+        idle.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    // Queues removal of `p` (a file or a whole tree) and returns immediately.
+    void remove_all(const fs::path& p, Batch& batch) {
+        {
+            std::lock_guard<std::mutex> lock(batch.m);
+            batch.pending++;
+        }
+        push(next_queue++ % queues.size(), new Node(p.string(), nullptr, &batch, nullptr));
+    }
+
+    // Queues a read-only walk of `p` that adds its files, directories and bytes to `usage`.
+    void measure(const fs::path& p, Usage& usage, Batch& batch) {
+        {
+            std::lock_guard<std::mutex> lock(batch.m);
+            batch.pending++;
+        }
+        push(next_queue++ % queues.size(), new Node(p.string(), nullptr, &batch, &usage));
+    }
+
+    // Queues a read-only walk of the folder `p` that records its orphans.
+    void scan_orphans(const fs::path& p, Orphans& orphans, Batch& batch) {
+        {
+            std::lock_guard<std::mutex> lock(batch.m);
+            batch.pending++;
+        }
+        Node* n = new Node(p.string(), nullptr, &batch, nullptr);
+        n->orphans = &orphans;
+        push(next_queue++ % queues.size(), n);
+    }
+
+    // Caps deletion at `unlinksPerSecond` removed entries and `bytesPerSecond` freed disk
+    // bytes (0: no cap). Call before queuing anything. Walks that only read are not limited.
+    void limit(double unlinksPerSecond, double bytesPerSecond) {
+        if (unlinksPerSecond > 0) unlink_bucket.reset(new TokenBucket(unlinksPerSecond));
+        if (bytesPerSecond > 0) byte_bucket.reset(new TokenBucket(bytesPerSecond));
+    }
+
+    Throttling throttling() const {
+        return {throttled_unlinks, throttled_bytes, throttled_waits, throttled_ns / 1e9};
+    }
+
+    // Blocks until everything queued on `batch` is gone; false if anything could not be deleted.
+    bool wait(Batch& batch) {
+        std::unique_lock<std::mutex> lock(batch.m);
+        batch.done.wait(lock, [&]() { return batch.pending == 0; });
+        return batch.ok;
+    }
 
-    if (fs::is_directory(p)) {
-        fs::directory_iterator iter(p);
-        while (iter != fs::directory_iterator()) {
-            auto& entry = *iter;
-            if (exceptions.count(entry.get_path().filename())) {
-                ++iter;
+private:
+    struct Node {
+        Node(std::string path, Node* parent, Batch* batch, Usage* usage)
+            : path(std::move(path)), parent(parent), batch(batch), usage(usage) {}
+        std::string path;
+        Node* parent;
+        Batch* batch;
+        Usage* usage; // set when measuring instead of deleting
+        Orphans* orphans = nullptr; // set when scanning for orphans instead of deleting
+        std::atomic<size_t> pending{1}; // the node's own scan plus one per queued subdirectory
+        std::atomic<bool> ok{true};
+#ifndef _WIN32
+        int fd = -1; // kept open until the last subdirectory is done, which is opened and removed relative to it
+#endif
+    };
+
+    struct Queue {
+        std::mutex m;
+        std::deque<Node*> tasks;
+    };
+
+    void push(size_t worker, Node* n) {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->m);
+            queues[worker]->tasks.push_back(n);
+        }
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            queued++;
+        }
+        idle.notify_one();
+    }
+
+    Node* take(size_t worker) {
+        for (size_t k = 0; k < queues.size(); ++k) {
+            Queue& q = *queues[(worker + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.m);
+            if (q.tasks.empty()) continue;
+            Node* n;
+            if (k == 0) {
+                n = q.tasks.back();
+                q.tasks.pop_back();
+            } else {
+                n = q.tasks.front();
+                q.tasks.pop_front();
+            }
+            return n;
+        }
+        return nullptr;
+    }
+
+    void run(size_t worker) {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(idle_mutex);
+                idle.wait(lock, [&]() { return stop || queued > 0; });
+                if (queued == 0) return;
+                queued--;
+            }
+            Node* n = nullptr;
+            while (!(n = take(worker))) std::this_thread::yield();
+            process(n, worker);
+        }
+    }
+
+    void process(Node* n, size_t worker) {
+        if (n->orphans) {
+            scan_directory(n, worker);
+            return;
+        }
+#ifdef _WIN32
+        if (n->usage) {
+            measure_directory(n, worker);
+            return;
+        }
+        n->ok = fs::remove_all(fs::path(n->path));
+        complete(n);
+#else
+        EntryStat st;
+        if (!n->parent) {
+            bool found = stat_entry(AT_FDCWD, n->path.c_str(), st);
+            if (!found || !st.dir) {
+                if (!n->usage && found) throttle(AT_FDCWD, n->path.c_str());
+                if (!n->usage) n->ok = (!found && errno == ENOENT) || unlink(n->path.c_str()) == 0;
+                if (n->usage && found) n->usage->add(false, st.size, st.allocated, st.used);
+                complete(n);
+                return;
+            }
+            if (n->usage) n->usage->add(true, 0, st.allocated, st.used);
+        }
+        int fd = openat(dir_fd(n), entry_name(n), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+            n->ok = false;
+            finish(n);
+            return;
+        }
+        n->fd = fd;
+        {
+            fs::directory_iterator iter(fcntl(fd, F_DUPFD_CLOEXEC, 0), fs::path(n->path));
+            if (!iter.is_open()) n->ok = false;
+            for (; iter != fs::directory_iterator(); ++iter) {
+                const char* name = iter->name();
+                bool is_dir;
+                if (n->usage) {
+                    if (!stat_entry(fd, name, st)) continue;
+                    is_dir = st.dir;
+                    n->usage->add(st.dir, st.size, st.allocated, st.used);
+                } else {
+                    is_dir = iter->type() == fs::file_type::directory;
+                }
+                if (is_dir) {
+                    n->pending++;
+                    push(worker, new Node(n->path + "/" + name, n, n->batch, n->usage));
+                } else if (!n->usage) {
+                    throttle(fd, name);
+                    if (unlinkat(fd, name, 0) != 0 && errno != ENOENT) n->ok = false;
+                }
+            }
+        }
+        finish(n);
+#endif
+    }
+
+#ifdef _WIN32
+    static int64_t unix_time(const FILETIME& t) {
+        return static_cast<int64_t>(((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10000000) -
+               11644473600LL;
+    }
+
+    void measure_directory(Node* n, size_t worker) {
+        WIN32_FILE_ATTRIBUTE_DATA attr;
+        if (!n->parent) {
+            if (!GetFileAttributesExA(n->path.c_str(), GetFileExInfoStandard, &attr)) {
+                complete(n);
+                return;
+            }
+            bool dir = (attr.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            uint64_t size = (static_cast<uint64_t>(attr.nFileSizeHigh) << 32) | attr.nFileSizeLow;
+            n->usage->add(dir, size, size,
+                          dir ? unix_time(attr.ftLastWriteTime)
+                              : std::max(unix_time(attr.ftLastAccessTime), unix_time(attr.ftLastWriteTime)));
+            if (!dir) {
+                complete(n);
+                return;
+            }
+        }
+        WIN32_FIND_DATAA findData;
+        HANDLE hFind = FindFirstFileA((n->path + "\\*").c_str(), &findData);
+        if (hFind != INVALID_HANDLE_VALUE) {
+            do {
+                if (strcmp(findData.cFileName, ".") == 0 || strcmp(findData.cFileName, "..") == 0) continue;
+                // Junctions and symlinked folders are removed as links, not followed.
+                bool dir = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+                           !(findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT);
+                uint64_t size = (static_cast<uint64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+                n->usage->add(dir, size, size,
+                              dir ? unix_time(findData.ftLastWriteTime)
+                                  : std::max(unix_time(findData.ftLastAccessTime), unix_time(findData.ftLastWriteTime)));
+                if (dir) {
+                    n->pending++;
+                    push(worker, new Node(n->path + "\\" + findData.cFileName, n, n->batch, n->usage));
+                }
+            } while (FindNextFileA(hFind, &findData));
+            FindClose(hFind);
+        }
+        finish(n);
+    }
+#endif
+
+#ifndef _WIN32
+    // A subdirectory is reached through its parent's open fd, never by its full path, so
+    // depth is not limited by PATH_MAX and a folder swapped for a symlink mid-run is not
+    // followed. Roots are opened relative to the working directory.
+    static int dir_fd(const Node* n) { return n->parent ? n->parent->fd : AT_FDCWD; }
+    static const char* entry_name(const Node* n) {
+        return n->parent ? n->path.c_str() + n->path.rfind('/') + 1 : n->path.c_str();
+    }
+
+    // Waits for the limits before one removal. Only a byte limit needs the entry's size,
+    // so `name` is stat'ed just then (and not at all for directories, passed as null).
+    void throttle(int dirFd, const char* name) {
+        if (!unlink_bucket && !byte_bucket) return;
+        std::chrono::nanoseconds held(0);
+        if (unlink_bucket) held += unlink_bucket->take(1);
+        EntryStat st;
+        if (byte_bucket && name && stat_entry(dirFd, name, st)) {
+            held += byte_bucket->take(static_cast<double>(st.allocated));
+            throttled_bytes += st.allocated;
+        }
+        throttled_unlinks++;
+        if (held.count() > 0) {
+            throttled_waits++;
+            throttled_ns += static_cast<uint64_t>(held.count());
+        }
+    }
+
+    struct EntryStat {
+        bool dir;
+        uint64_t size;
+        uint64_t allocated;
+        int64_t used; // latest of access and modification time; mtime only for directories
+    };
+
+    // statx asks only for the fields a measurement needs and, on network file systems,
+    // takes cached attributes instead of a server round trip per entry. A directory's
+    // atime moves whenever it is listed, measuring included, so it is not a sign of use.
+    static bool stat_entry(int dirFd, const char* name, EntryStat& out) {
+#if defined(__linux__) && defined(STATX_TYPE)
+        struct statx sx;
+        if (statx(dirFd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+                  STATX_TYPE | STATX_SIZE | STATX_BLOCKS | STATX_ATIME | STATX_MTIME, &sx) == 0) {
+            out.dir = S_ISDIR(sx.stx_mode);
+            out.size = sx.stx_size;
+            out.allocated = sx.stx_blocks * 512;
+            out.used = out.dir ? sx.stx_mtime.tv_sec : std::max<int64_t>(sx.stx_atime.tv_sec, sx.stx_mtime.tv_sec);
+            return true;
+        }
+        if (errno != ENOSYS) return false;
+#endif
+        struct stat info;
+        if (fstatat(dirFd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) return false;
+        out.dir = S_ISDIR(info.st_mode);
+        out.size = static_cast<uint64_t>(info.st_size);
+        out.allocated = static_cast<uint64_t>(info.st_blocks) * 512;
+        out.used = out.dir ? info.st_mtime : std::max<int64_t>(info.st_atime, info.st_mtime);
+        return true;
+    }
+#endif
+
+    // Unity skips hidden entries, names ending in '~', "cvs" folders and *.tmp files; they never get a .meta.
+    static bool unity_ignores(const std::string& name) {
+        std::string lower = name;
+        for (auto& c : lower) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        return name.empty() || name[0] == '.' || name.back() == '~' || lower == "cvs" ||
+               (lower.size() > 4 && lower.compare(lower.size() - 4, 4, ".tmp") == 0);
+    }
+
+    // Pairs every entry of one folder with its .meta through a hash set of the folder's names.
+    void scan_directory(Node* n, size_t worker) {
+        std::vector<std::pair<std::string, fs::file_type>> entries;
+        std::unordered_set<std::string> names;
+        bool listed = fs::for_each_entry(fs::path(n->path), [&](const std::string& name, fs::file_type type) {
+            entries.push_back({name, type});
+            names.insert(name);
+        });
+        if (!listed) n->ok = false;
+        std::vector<std::string> metas, assets;
+        for (const auto& e : entries) {
+            const std::string& name = e.first;
+            if (unity_ignores(name)) continue;
+            bool isMeta = name.size() > 5 && name.compare(name.size() - 5, 5, ".meta") == 0;
+            if (isMeta && e.second != fs::file_type::directory) {
+                if (!names.count(name.substr(0, name.size() - 5))) metas.push_back((fs::path(n->path) / name).string());
                 continue;
             }
-            try {
-                fs::remove_all(entry.get_path());
-            } catch (...) {}
-            ++iter;
+            if (!names.count(name + ".meta")) assets.push_back((fs::path(n->path) / name).string());
+            if (e.second == fs::file_type::directory) {
+                n->pending++;
+                Node* child = new Node((fs::path(n->path) / name).string(), n, n->batch, nullptr);
+                child->orphans = n->orphans;
+                push(worker, child);
+            }
+        }
+        if (!metas.empty() || !assets.empty()) {
+            std::lock_guard<std::mutex> lock(n->orphans->m);
+            n->orphans->metas.insert(n->orphans->metas.end(), metas.begin(), metas.end());
+            n->orphans->assets.insert(n->orphans->assets.end(), assets.begin(), assets.end());
+        }
+        finish(n);
+    }
+
+    // Drops one reference from `n`; the last one removes the directory and walks up.
+    void finish(Node* n) {
+        while (n && --n->pending == 0) {
+#ifndef _WIN32
+            if (n->fd >= 0) close(n->fd);
+            if (!n->usage && !n->orphans && n->ok) {
+                throttle(AT_FDCWD, nullptr);
+                if (unlinkat(dir_fd(n), entry_name(n), AT_REMOVEDIR) != 0 && errno != ENOENT) n->ok = false;
+            }
+#endif
+            Node* parent = n->parent;
+            if (parent && !n->ok) parent->ok = false;
+            if (!parent) {
+                complete(n);
+                return;
+            }
+            delete n;
+            n = parent;
         }
+    }
 
-        try {
-            if (fs::is_empty(p)) {
-                fs::remove(p);
+    // Reports a finished root to its batch and frees it.
+    void complete(Node* n) {
+        Batch& batch = *n->batch;
+        bool ok = n->ok;
+        delete n;
+        std::lock_guard<std::mutex> lock(batch.m);
+        if (!ok) batch.ok = false;
+        if (--batch.pending == 0) batch.done.notify_all();
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+    size_t queued = 0;
+    bool stop = false;
+    std::atomic<size_t> next_queue{0};
+    std::unique_ptr<TokenBucket> unlink_bucket;
+    std::unique_ptr<TokenBucket> byte_bucket;
+    std::atomic<uint64_t> throttled_unlinks{0};
+    std::atomic<uint64_t> throttled_bytes{0};
+    std::atomic<uint64_t> throttled_waits{0};
+    std::atomic<uint64_t> throttled_ns{0};
+};
+
+// Matches one path segment against a glob: "*" any run of characters, "?" one
+// character, "[abc]", "[a-z]" and "[!abc]" one character of (or not of) a set.
+bool glob_match(const std::string& pattern, const std::string& name) {
+    size_t p = 0, n = 0, starP = std::string::npos, starN = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            starP = p++;
+            starN = n;
+            continue;
+        }
+        if (p < pattern.size() && pattern[p] == '[') {
+            size_t q = p + 1;
+            bool negate = q < pattern.size() && pattern[q] == '!';
+            if (negate) ++q;
+            bool found = false;
+            size_t first = q;
+            while (q < pattern.size() && (pattern[q] != ']' || q == first)) {
+                if (q + 2 < pattern.size() && pattern[q + 1] == '-' && pattern[q + 2] != ']') {
+                    if (name[n] >= pattern[q] && name[n] <= pattern[q + 2]) found = true;
+                    q += 3;
+                } else {
+                    if (name[n] == pattern[q]) found = true;
+                    ++q;
+                }
+            }
+            if (q < pattern.size() && found != negate) {
+                p = q + 1;
+                ++n;
+                continue;
             }
-        } catch (...) {}
-    } else {
-        try {
-            fs::remove(p);
-        } catch (...) {}
+        } else if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            ++p;
+            ++n;
+            continue;
+        }
+        if (starP == std::string::npos) return false;
+        p = starP + 1;
+        n = ++starN;
     }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
 }
 
-void clear_directory(const fs::path& p) {
-    if (fs::exists(p) && fs::is_directory(p)) {
-        fs::directory_iterator iter(p);
-        while (iter != fs::directory_iterator()) {
-            auto& entry = *iter;
-            try {
-                fs::remove_all(entry.get_path());
-            } catch (...) {}
-            ++iter;
-        }
+bool is_glob(const std::string& s) {
+    return s.find_first_of("*?[") != std::string::npos;
+}
+
+// Exceptions name entries directly inside the rule's folder, as exact names or globs.
+bool is_exception(const std::set<std::string>& exceptions, const std::string& name) {
+    if (exceptions.count(name)) return true;
+    for (const auto& e : exceptions) {
+        if (is_glob(e) && glob_match(e, name)) return true;
     }
+    return false;
 }
 
-int main(int argc, char* argv[]) {
-    fs::path projectRoot = (argc > 1) ? argv[1] : fs::current_path();
-    fs::path exeDir = fs::path(argv[0]).parent_path();
-    fs::path configPath = exeDir / "cleanup_list.txt";
+struct CleanupRule {
+    std::string action;
+    std::string relPath;
+    std::set<std::string> exceptions;
+    std::string pattern; // the path as written in cleanup_list.txt, for rules expanded from a glob
+};
 
-    if (!fs::exists(configPath)) return 1;
+// Trash folder of --trash runs and the --snapshot folder, in the project root; never matched by rules.
+const char* kTrashDir = ".sncleaner-trash";
+const char* kSnapshotDir = ".sncleaner-snapshot";
 
+std::vector<CleanupRule> load_rules(const fs::path& configPath) {
+    std::vector<CleanupRule> rules;
     std::ifstream configFile(configPath.string());
     std::string line;
 
@@ -287,12 +1017,12 @@ int main(int argc, char* argv[]) {
         size_t actionSep = line.find(':');
         if (actionSep == std::string::npos) continue;
 
-        std::string action = line.substr(0, actionSep);
+        CleanupRule rule;
+        rule.action = line.substr(0, actionSep);
         std::string pathData = line.substr(actionSep + 1);
 
         size_t exSep = pathData.find('|');
-        std::string relPath = pathData.substr(0, exSep);
-        std::set<std::string> exceptions;
+        rule.relPath = pathData.substr(0, exSep);
 
         if (exSep != std::string::npos) {
             std::string exString = pathData.substr(exSep + 1);
@@ -302,44 +1032,1149 @@ int main(int argc, char* argv[]) {
                 while (!segment.empty() && (segment.back() == '\r' || segment.back() == '\n' || segment.back() == ' ')) {
                     segment.pop_back();
                 }
-                if (!segment.empty()) exceptions.insert(segment);
+                if (!segment.empty()) rule.exceptions.insert(segment);
             }
         }
 
-        while (!relPath.empty() && (relPath.back() == '\r' || relPath.back() == '\n' || relPath.back() == ' ')) {
-            relPath.pop_back();
+        while (!rule.relPath.empty() && (rule.relPath.back() == '\r' || rule.relPath.back() == '\n' || rule.relPath.back() == ' ')) {
+            rule.relPath.pop_back();
         }
+        rules.push_back(rule);
+    }
+    return rules;
+}
 
-        fs::path fullPath = projectRoot / relPath;
-        if (!fs::exists(fullPath)) continue;
+// Rule paths are compared '/'-separated and without a trailing slash.
+std::string normalize_rel(std::string p) {
+    for (auto& c : p) if (c == '\\') c = '/';
+    while (!p.empty() && p.back() == '/') p.pop_back();
+    return p;
+}
 
-        try {
-            if (action == "DELETE") {
-                if (!exceptions.empty()) {
-                    delete_with_exceptions(fullPath, exceptions);
-                } else {
-                    fs::remove_all(fullPath);
+// Calls `fn` with `p`, then each folder containing it, ending with "" (the project root).
+template <typename Fn>
+void for_each_ancestor(std::string p, Fn fn) {
+    for (;;) {
+        fn(p);
+        if (p.empty()) return;
+        size_t slash = p.find_last_of('/');
+        p.erase(slash == std::string::npos ? 0 : slash);
+    }
+}
+
+// All rule paths compiled into one matcher over path segments and walked once from the
+// project root. Literal segments are probed with one lstat per name, so only folders a
+// glob ("*", "?", "[...]") or "**" (any number of folders) can match in are listed.
+// Rules later in the file do not enter an entry an earlier rule deletes outright.
+class RuleMatcher {
+public:
+    explicit RuleMatcher(const std::vector<CleanupRule>& rules) : rules(rules) {
+        for (const auto& rule : rules) {
+            std::string normalized = rule.relPath;
+            for (auto& c : normalized) if (c == '\\') c = '/';
+            std::vector<std::string> segments;
+            std::stringstream ss(normalized);
+            std::string segment;
+            while (std::getline(ss, segment, '/')) {
+                if (!segment.empty() && segment != ".") segments.push_back(segment);
+            }
+            // A trailing "**" means everything inside, not the folder itself.
+            if (!segments.empty() && segments.back() == "**") segments.push_back("*");
+            bool glob = false;
+            for (const auto& seg : segments) glob = glob || seg == "**" || is_glob(seg);
+            patterns.push_back(segments);
+            globs.push_back(glob);
+            anyGlob = anyGlob || glob;
+        }
+    }
+
+    // The rules in file order, each glob rule replaced by one rule per matching path.
+    std::vector<CleanupRule> expand(const fs::path& projectRoot) const {
+        std::vector<std::vector<std::string>> matches(rules.size());
+        if (anyGlob) {
+            std::vector<State> start;
+            for (size_t r = 0; r < rules.size(); ++r) {
+                if (!patterns[r].empty()) start.push_back({r, 0});
+            }
+            walk(projectRoot, "", close(start), matches);
+        }
+        std::vector<CleanupRule> expanded;
+        for (size_t r = 0; r < rules.size(); ++r) {
+            if (!globs[r]) {
+                expanded.push_back(rules[r]);
+                continue;
+            }
+            std::sort(matches[r].begin(), matches[r].end());
+            for (const auto& m : matches[r]) {
+                CleanupRule rule = rules[r];
+                rule.relPath = m;
+                rule.pattern = rules[r].relPath;
+                expanded.push_back(rule);
+            }
+        }
+        return expanded;
+    }
+
+private:
+    struct State {
+        size_t rule;
+        size_t segment; // next segment to match
+        bool operator<(const State& o) const { return rule != o.rule ? rule < o.rule : segment < o.segment; }
+        bool operator==(const State& o) const { return rule == o.rule && segment == o.segment; }
+    };
+
+    // Adds the states reached by letting each "**" match no folder at all.
+    std::vector<State> close(std::vector<State> states) const {
+        for (size_t i = 0; i < states.size(); ++i) {
+            State st = states[i];
+            if (patterns[st.rule][st.segment] == "**") states.push_back({st.rule, st.segment + 1});
+        }
+        std::sort(states.begin(), states.end());
+        states.erase(std::unique(states.begin(), states.end()), states.end());
+        return states;
+    }
+
+    bool removes_outright(size_t r, bool isDir) const {
+        const CleanupRule& rule = rules[r];
+        return (rule.action == "DELETE" && rule.exceptions.empty()) || (rule.action == "CLEAR" && isDir);
+    }
+
+    void walk(const fs::path& dir, const std::string& rel, const std::vector<State>& states,
+              std::vector<std::vector<std::string>>& matches) const {
+        bool list = false;
+        std::set<std::string> literals;
+        for (const auto& st : states) {
+            const std::string& seg = patterns[st.rule][st.segment];
+            if (seg == "**" || is_glob(seg)) {
+                list = true;
+            } else {
+                literals.insert(seg);
+            }
+        }
+
+        auto visit = [&](const std::string& name, fs::file_type type) {
+            if (rel.empty() && (name == kTrashDir || name == kSnapshotDir)) return;
+            bool isDir = type == fs::file_type::directory;
+            std::string childRel = rel.empty() ? name : rel + "/" + name;
+            std::vector<State> next;
+            size_t cut = rules.size();
+            for (const auto& st : states) {
+                const std::string& seg = patterns[st.rule][st.segment];
+                if (seg == "**") {
+                    if (isDir) next.push_back(st);
+                    continue;
                 }
+                if (!glob_match(seg, name)) continue;
+                if (st.segment + 1 < patterns[st.rule].size()) {
+                    next.push_back({st.rule, st.segment + 1});
+                    continue;
+                }
+                auto& found = matches[st.rule];
+                if (found.empty() || found.back() != childRel) found.push_back(childRel);
+                if (removes_outright(st.rule, isDir)) cut = std::min(cut, st.rule);
             }
-            else if (action == "CLEAR") {
-                clear_directory(fullPath);
+            if (!isDir) return;
+            next.erase(std::remove_if(next.begin(), next.end(), [&](const State& st) { return st.rule >= cut; }), next.end());
+            if (!next.empty()) walk(dir / name, childRel, close(next), matches);
+        };
+
+        if (list) {
+            fs::for_each_entry(dir, visit);
+        } else {
+            for (const auto& name : literals) {
+                fs::file_type type = fs::symlink_status(dir / name);
+                if (type != fs::file_type::not_found) visit(name, type);
             }
-        } catch (...) {}
+        }
     }
 
-    fs::path webglRoot = projectRoot / "Assets/WebGLTemplates";
-    if (fs::exists(webglRoot)) {
-        fs::directory_iterator iter(webglRoot);
-        while (iter != fs::directory_iterator()) {
-            auto& entry = *iter;
-            if (entry.get_path().filename() != "SNEngine") {
-                try {
-                    fs::remove_all(entry.get_path());
-                } catch (...) {}
+    const std::vector<CleanupRule>& rules;
+    std::vector<std::vector<std::string>> patterns;
+    std::vector<bool> globs;
+    bool anyGlob = false;
+};
+
+// Groups rules whose paths nest (one contains the other) into chains that keep file
+// order. Each path is only compared with its own ancestors, so thousands of glob
+// matches stay cheap.
+std::vector<std::vector<size_t>> chain_rules(const std::vector<CleanupRule>& rules) {
+    std::vector<size_t> head(rules.size());
+    auto find = [&](size_t i) {
+        while (head[i] != i) i = head[i] = head[head[i]];
+        return i;
+    };
+    std::unordered_map<std::string, size_t> firstWithPath;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        head[i] = i;
+        firstWithPath.emplace(normalize_rel(rules[i].relPath), i);
+    }
+    for (size_t i = 0; i < rules.size(); ++i) {
+        for_each_ancestor(normalize_rel(rules[i].relPath), [&](const std::string& p) {
+            auto it = firstWithPath.find(p);
+            if (it == firstWithPath.end()) return;
+            size_t a = find(i), b = find(it->second);
+            if (a != b) head[std::max(a, b)] = std::min(a, b);
+        });
+    }
+    std::vector<std::vector<size_t>> chains;
+    std::unordered_map<size_t, size_t> chainOf;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        auto it = chainOf.emplace(find(i), chains.size()).first;
+        if (it->second == chains.size()) chains.emplace_back();
+        chains[it->second].push_back(i);
+    }
+    return chains;
+}
+
+// What one rule would remove: the entries it deletes directly (relative to the
+// project root) and the size of everything below them.
+struct RulePlan {
+    std::string action;
+    std::string relPath;
+    std::set<std::string> exceptions;
+    std::string pattern;
+    bool builtin = false;
+    bool exists = false;
+    bool removesSelf = false; // DELETE with exceptions removes the folder once it is empty
+    bool listsChildren = false; // targets are the folder's entries rather than the folder
+    std::vector<std::string> targets;
+    std::vector<std::string> kept; // entries of a listed folder that stay, with their .meta
+    std::vector<std::unique_ptr<ParallelDeleter::Usage>> usage; // one per target
+};
+
+std::string join_rel(const std::string& dir, const std::string& name) {
+    return dir.empty() ? name : dir + "/" + name;
+}
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Unity keeps a "<asset>.meta" next to every asset and folder; it goes with the asset.
+void add_companion_meta(RulePlan& plan, const std::string& relPath, const fs::path& projectRoot) {
+    std::string meta = normalize_rel(relPath);
+    if (meta.empty() || ends_with(meta, ".meta")) return;
+    meta += ".meta";
+    if (fs::symlink_status(projectRoot / meta) != fs::file_type::not_found) plan.targets.push_back(meta);
+}
+
+// Lists the top-level targets of a rule: what apply_plan() removes, --trash moves and
+// --plan measures. Deleted assets take their .meta along; kept ones keep theirs.
+RulePlan plan_rule(const std::string& action, const std::string& relPath, const std::set<std::string>& exceptions,
+                   const fs::path& projectRoot) {
+    RulePlan plan;
+    plan.action = action;
+    plan.relPath = relPath;
+    plan.exceptions = exceptions;
+    fs::path fullPath = projectRoot / relPath;
+    plan.exists = fs::exists(fullPath);
+    if (!plan.exists) {
+        // A .meta left behind by an earlier cleanup is still removed.
+        if (action == "DELETE") add_companion_meta(plan, relPath, projectRoot);
+        return plan;
+    }
+
+    bool listChildren = fs::is_directory(fullPath) &&
+                        (action == "CLEAR" || (action == "DELETE" && !exceptions.empty()));
+    if (action == "DELETE" && !listChildren) {
+        plan.targets.push_back(relPath);
+        add_companion_meta(plan, relPath, projectRoot);
+    } else if (listChildren) {
+        std::vector<std::string> names;
+        std::set<std::string> kept;
+        for (fs::directory_iterator iter(fullPath), end; iter != end; ++iter) {
+            std::string name = iter->name();
+            if (is_exception(exceptions, name)) {
+                kept.insert(name);
+                plan.kept.push_back(join_rel(relPath, name));
+            } else {
+                names.push_back(name);
+            }
+        }
+        for (const auto& name : names) {
+            if (ends_with(name, ".meta") && kept.count(name.substr(0, name.size() - 5))) {
+                plan.kept.push_back(join_rel(relPath, name));
+                continue;
             }
-            ++iter;
+            plan.targets.push_back(join_rel(relPath, name));
         }
+        plan.listsChildren = true;
+        plan.removesSelf = action == "DELETE" && kept.empty();
+        if (plan.removesSelf) add_companion_meta(plan, relPath, projectRoot);
     }
+    return plan;
+}
+
+RulePlan plan_rule(const CleanupRule& rule, const fs::path& projectRoot) {
+    // CLEAR has never honoured exceptions, so the plan must not either.
+    std::set<std::string> exceptions = rule.action == "CLEAR" ? std::set<std::string>() : rule.exceptions;
+    RulePlan plan = plan_rule(rule.action, rule.relPath, exceptions, projectRoot);
+    plan.pattern = rule.pattern;
+    return plan;
+}
+
+RulePlan plan_webgl_templates(const fs::path& projectRoot) {
+    RulePlan plan = plan_rule("CLEAR", "Assets/WebGLTemplates", {"SNEngine"}, projectRoot);
+    plan.builtin = true;
+    return plan;
+}
+
+// False if anything the plan targets could not be deleted.
+bool apply_plan(const RulePlan& plan, const fs::path& projectRoot, ParallelDeleter& deleter) {
+    ParallelDeleter::Batch batch;
+    for (const auto& target : plan.targets) deleter.remove_all(projectRoot / target, batch);
+    bool ok = deleter.wait(batch);
+    fs::path self = projectRoot / plan.relPath;
+    if (plan.removesSelf && fs::is_empty(self)) fs::remove(self);
+    return ok;
+}
 
-    return 0;
-}
\ No newline at end of file
+bool apply_rule(const CleanupRule& rule, const fs::path& projectRoot, ParallelDeleter& deleter) {
+    return apply_plan(plan_rule(rule, projectRoot), projectRoot, deleter);
+}
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+        else out += c;
+    }
+    return out;
+}
+
+// Measures every target of every rule on the deleter's workers and writes the plan as
+// JSON. Nothing is deleted. Rules run in file order where their paths nest, so a
+// target already inside an earlier rule's target is skipped, and an earlier target
+// inside a later one is not counted twice.
+bool write_plan(std::vector<RulePlan>& plans, const fs::path& projectRoot, ParallelDeleter& deleter, std::ostream& out) {
+    struct Measured {
+        std::string rel;
+        ParallelDeleter::Usage* usage;
+    };
+    std::vector<Measured> measured;
+    std::unordered_map<std::string, size_t> measuredAt;
+    ParallelDeleter::Batch batch;
+    for (auto& plan : plans) {
+        std::vector<std::string> targets;
+        for (const auto& t : plan.targets) {
+            bool covered = false;
+            for_each_ancestor(normalize_rel(t), [&](const std::string& p) { covered = covered || measuredAt.count(p); });
+            if (covered) continue;
+            targets.push_back(t);
+            plan.usage.emplace_back(new ParallelDeleter::Usage());
+            deleter.measure(projectRoot / t, *plan.usage.back(), batch);
+        }
+        plan.targets.swap(targets);
+        for (size_t i = 0; i < plan.targets.size(); ++i) {
+            measuredAt.emplace(normalize_rel(plan.targets[i]), measured.size());
+            measured.push_back({plan.targets[i], plan.usage[i].get()});
+        }
+    }
+    bool ok = deleter.wait(batch);
+
+    // Every measured folder around an earlier target is a later one (otherwise the earlier
+    // target would have been skipped); the nearest one gives that target's whole size back.
+    std::vector<std::pair<size_t, size_t>> nested;
+    for (size_t j = 0; j < measured.size(); ++j) {
+        std::string self = normalize_rel(measured[j].rel);
+        bool found = false;
+        for_each_ancestor(self, [&](const std::string& p) {
+            if (found || p.size() == self.size()) return;
+            auto it = measuredAt.find(p);
+            if (it == measuredAt.end()) return;
+            nested.push_back({it->second, j});
+            found = true;
+        });
+    }
+    std::vector<uint64_t> files(measured.size()), dirs(measured.size()), bytes(measured.size());
+    for (size_t i = 0; i < measured.size(); ++i) {
+        files[i] = measured[i].usage->files;
+        dirs[i] = measured[i].usage->directories;
+        bytes[i] = measured[i].usage->bytes;
+    }
+    for (const auto& n : nested) {
+        measured[n.first].usage->files -= files[n.second];
+        measured[n.first].usage->directories -= dirs[n.second];
+        measured[n.first].usage->bytes -= bytes[n.second];
+    }
+
+    uint64_t totalFiles = 0, totalDirs = 0, totalBytes = 0;
+    out << "{\n  \"root\": \"" << json_escape(projectRoot.string()) << "\",\n  \"complete\": " << (ok ? "true" : "false")
+        << ",\n  \"rules\": [";
+    for (size_t r = 0; r < plans.size(); ++r) {
+        const RulePlan& plan = plans[r];
+        uint64_t files = 0, dirs = plan.removesSelf ? 1 : 0, bytes = 0;
+        for (const auto& u : plan.usage) {
+            files += u->files;
+            dirs += u->directories;
+            bytes += u->bytes;
+        }
+        totalFiles += files;
+        totalDirs += dirs;
+        totalBytes += bytes;
+        out << (r ? "," : "") << "\n    {\"action\": \"" << json_escape(plan.action) << "\", \"path\": \""
+            << json_escape(plan.relPath) << "\"";
+        if (!plan.pattern.empty()) out << ", \"rule\": \"" << json_escape(plan.pattern) << "\"";
+        if (plan.builtin) out << ", \"builtin\": true";
+        out << ", \"exceptions\": [";
+        size_t k = 0;
+        for (const auto& e : plan.exceptions) out << (k++ ? ", " : "") << "\"" << json_escape(e) << "\"";
+        out << "], \"exists\": " << (plan.exists ? "true" : "false") << ", \"files\": " << files
+            << ", \"directories\": " << dirs << ", \"bytes\": " << bytes << ", \"targets\": [";
+        for (size_t t = 0; t < plan.targets.size(); ++t) {
+            out << (t ? ", " : "") << "\"" << json_escape(plan.targets[t]) << "\"";
+        }
+        out << "]}";
+    }
+    out << "\n  ],\n  \"total\": {\"files\": " << totalFiles << ", \"directories\": " << totalDirs
+        << ", \"bytes\": " << totalBytes << "}\n}\n";
+    return ok;
+}
+
+// Walks Assets/ once on the deleter's workers and writes every orphaned .meta and every
+// asset without a .meta as JSON, paths relative to the project root. Nothing is deleted.
+bool write_orphans(const fs::path& projectRoot, ParallelDeleter& deleter, std::ostream& out) {
+    ParallelDeleter::Orphans orphans;
+    ParallelDeleter::Batch batch;
+    fs::path assets = projectRoot / "Assets";
+    bool ok = fs::is_directory(assets);
+    if (ok) {
+        deleter.scan_orphans(assets, orphans, batch);
+        ok = deleter.wait(batch);
+    }
+    size_t prefix = projectRoot.string().size() + 1;
+    auto write_list = [&](std::vector<std::string>& paths) {
+        for (auto& p : paths) p = normalize_rel(p.substr(std::min(prefix, p.size())));
+        std::sort(paths.begin(), paths.end());
+        for (size_t i = 0; i < paths.size(); ++i) out << (i ? "," : "") << "\n    \"" << json_escape(paths[i]) << "\"";
+        out << (paths.empty() ? "]" : "\n  ]");
+    };
+    out << "{\n  \"root\": \"" << json_escape(projectRoot.string()) << "\",\n  \"complete\": " << (ok ? "true" : "false")
+        << ",\n  \"orphan_metas\": [";
+    write_list(orphans.metas);
+    out << ",\n  \"missing_metas\": [";
+    write_list(orphans.assets);
+    out << "\n}\n";
+    return ok;
+}
+
+// --trash moves targets into <project>/.sncleaner-trash/<timestamp>-<pid>/ and returns;
+// the rename stays on the project's filesystem, so it costs one metadata update per
+// target however large the tree is. A detached "--reap" process deletes the trash
+// afterwards at background priority.
+
+class Trash {
+public:
+    Trash() = default;
+    Trash(const Trash&) = delete;
+    Trash& operator=(const Trash&) = delete;
+    ~Trash() { close(); }
+
+    // Creates this run's folder inside the trash. False when the project root is not writable.
+    bool open(const fs::path& projectRoot) {
+        char stamp[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+#ifdef _WIN32
+        std::string root = (projectRoot / kTrashDir).string();
+        CreateDirectoryA(root.c_str(), nullptr);
+        SetFileAttributesA(root.c_str(), FILE_ATTRIBUTE_HIDDEN);
+        dir = root + "\\" + stamp + "-" + std::to_string(GetCurrentProcessId());
+        return CreateDirectoryA(dir.c_str(), nullptr) != 0;
+#else
+        std::string root = (projectRoot / kTrashDir).string();
+        if (mkdir(root.c_str(), 0700) != 0 && errno != EEXIST) return false;
+        int rootFd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (rootFd < 0) return false;
+        // The run's folder is locked while it is filled, so a reaper skips it instead of this
+        // run waiting for the reaper. A reaper can still take the new, empty folder before the
+        // lock is held; one with no links left is replaced by another.
+        std::string base = std::string(stamp) + "-" + std::to_string(getpid());
+        for (int attempt = 0; attempt < 8 && dirFd < 0; ++attempt) {
+            std::string name = attempt == 0 ? base : base + "-" + std::to_string(attempt);
+            if (mkdirat(rootFd, name.c_str(), 0700) != 0) break;
+            dirFd = openat(rootFd, name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            struct stat info;
+            if (dirFd >= 0 && flock(dirFd, LOCK_EX | LOCK_NB) == 0 && fstat(dirFd, &info) == 0 && info.st_nlink > 0) break;
+            if (dirFd >= 0) ::close(dirFd);
+            dirFd = -1;
+        }
+        ::close(rootFd);
+        return dirFd >= 0;
+#endif
+    }
+
+    // Renames `p` into the trash; false (leaving `p` in place) if it cannot be moved,
+    // e.g. because it is a mount point on another filesystem.
+    bool move(const fs::path& p) {
+        std::string name = std::to_string(count++) + "-" + p.filename();
+#ifdef _WIN32
+        return MoveFileExA(p.string().c_str(), (dir + "\\" + name).c_str(), 0) != 0;
+#else
+        if (dirFd < 0) return false;
+#ifdef __linux__
+        if (renameat2(AT_FDCWD, p.string().c_str(), dirFd, name.c_str(), RENAME_NOREPLACE) == 0) return true;
+        if (errno != EINVAL && errno != ENOSYS) return false;
+#endif
+        return renameat(AT_FDCWD, p.string().c_str(), dirFd, name.c_str()) == 0;
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (dirFd >= 0) ::close(dirFd);
+        dirFd = -1;
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    std::string dir;
+#else
+    int dirFd = -1;
+#endif
+    size_t count = 0;
+};
+
+// Lowers this process to idle I/O and CPU priority so it only uses the disk and the CPU
+// when nothing else does.
+void set_background_priority() {
+#ifdef _WIN32
+    SetPriorityClass(GetCurrentProcess(), PROCESS_MODE_BACKGROUND_BEGIN);
+#else
+#ifdef SYS_ioprio_set
+    const int ioprioWhoProcess = 1, ioprioClassIdle = 3, ioprioClassShift = 13;
+    syscall(SYS_ioprio_set, ioprioWhoProcess, 0, ioprioClassIdle << ioprioClassShift);
+#endif
+    // Threads inherit both settings, so this has to run before any ParallelDeleter exists.
+#ifdef SCHED_IDLE
+    struct sched_param param = {};
+    if (sched_setscheduler(0, SCHED_IDLE, &param) == 0) return;
+#endif
+    setpriority(PRIO_PROCESS, 0, 19);
+#endif
+}
+
+// Starts "<this exe> <root> --reap" detached from the caller: own session, no inherited
+// stdio (Unity waits for the output pipes to close) and not a child of this process.
+bool spawn_reaper(const char* argv0, const fs::path& projectRoot, unsigned jobs, const std::vector<std::string>& limits) {
+    std::string jobsArg = std::to_string(jobs);
+#ifdef _WIN32
+    (void)argv0;
+    char self[MAX_PATH];
+    if (!GetModuleFileNameA(nullptr, self, MAX_PATH)) return false;
+    std::string root = projectRoot.string();
+    while (!root.empty() && (root.back() == '\\' || root.back() == '/')) root.pop_back();
+    std::string cmd = "\"" + std::string(self) + "\" \"" + root + "\" --reap --jobs " + jobsArg;
+    for (const auto& arg : limits) cmd += " " + arg;
+    STARTUPINFOA si = {};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi;
+    if (!CreateProcessA(self, &cmd[0], nullptr, nullptr, FALSE, DETACHED_PROCESS | CREATE_NO_WINDOW | IDLE_PRIORITY_CLASS,
+                        nullptr, nullptr, &si, &pi)) {
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    return true;
+#else
+    // Everything the child needs is prepared before fork(); after it only async-signal-safe calls are made.
+    std::string root = projectRoot.string();
+    std::vector<const char*> args = {"SNEngine_Cleaner", root.c_str(), "--reap", "--jobs", jobsArg.c_str()};
+    for (const auto& arg : limits) args.push_back(arg.c_str());
+    args.push_back(nullptr);
+#ifdef __linux__
+    const char* self = "/proc/self/exe";
+    (void)argv0;
+#else
+    const char* self = argv0;
+#endif
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        setsid();
+        int null = ::open("/dev/null", O_RDWR);
+        if (null >= 0) {
+            dup2(null, 0);
+            dup2(null, 1);
+            dup2(null, 2);
+        }
+        if (fork() != 0) _exit(0);
+        execv(self, const_cast<char* const*>(args.data()));
+        _exit(127);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+// Deletes everything in the trash. Each run's folder is locked while it is deleted; one
+// that is locked already, by a --trash run still moving into it or by another reaper,
+// is skipped and left for the next reaper.
+void reap_trash(const fs::path& projectRoot, ParallelDeleter& deleter) {
+    fs::path trashRoot = projectRoot / kTrashDir;
+    if (!fs::is_directory(trashRoot)) return;
+#ifndef _WIN32
+    std::vector<int> locks;
+#endif
+    ParallelDeleter::Batch batch;
+    for (fs::directory_iterator iter(trashRoot), end; iter != end; ++iter) {
+#ifndef _WIN32
+        if (iter->type() == fs::file_type::directory) {
+            int fd = openat(iter.fd(), iter->name(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd < 0) continue;
+            if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+                close(fd);
+                continue;
+            }
+            locks.push_back(fd);
+        }
+#endif
+        deleter.remove_all(iter->get_path(), batch);
+    }
+    deleter.wait(batch);
+#ifndef _WIN32
+    for (int fd : locks) close(fd);
+#endif
+}
+
+// --snapshot saves everything a run is about to remove in <project>/.sncleaner-snapshot
+// before anything is deleted, and --restore moves it back. Files are cloned with
+// FICLONE where the file system supports reflinks and hard-linked otherwise, so a
+// snapshot costs metadata rather than data. Only the latest snapshot is kept.
+//
+// The manifest lists one record per line as "<kind> <length>:<path>": T for a saved
+// target (under tree/), S for a folder whose entries the run removed and K for an
+// entry of such a folder that was kept. On restore, entries that have appeared in an
+// S folder since are removed, so the folder ends up exactly as it was.
+#ifdef _WIN32
+bool clone_path(const fs::path& src, const fs::path& dst) {
+    if (fs::symlink_status(src) == fs::file_type::directory) {
+        if (!CreateDirectoryA(dst.string().c_str(), nullptr)) return false;
+        bool ok = true;
+        for (fs::directory_iterator iter(src), end; iter != end; ++iter) {
+            ok = clone_path(iter->get_path(), dst / iter->name()) && ok;
+        }
+        return ok;
+    }
+    return CreateHardLinkA(dst.string().c_str(), src.string().c_str(), nullptr) != 0 ||
+           CopyFileA(src.string().c_str(), dst.string().c_str(), TRUE) != 0;
+}
+#else
+// Clones `name` from `srcDir` into `dstDir`. A reflinked file gets its own inode with the
+// original mode and times; a hard link is the original inode. `reflink` is cleared the
+// first time the file system refuses a clone.
+bool clone_entry(int srcDir, const char* name, int dstDir, bool& reflink) {
+    struct stat info;
+    if (fstatat(srcDir, name, &info, AT_SYMLINK_NOFOLLOW) != 0) return false;
+    const struct timespec times[2] = {info.st_atim, info.st_mtim};
+    if (S_ISDIR(info.st_mode)) {
+        const int flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+        int src = openat(srcDir, name, flags);
+        if (src < 0) return false;
+        int dst = mkdirat(dstDir, name, 0700) == 0 ? openat(dstDir, name, flags) : -1;
+        if (dst < 0) {
+            close(src);
+            return false;
+        }
+        bool ok;
+        {
+            fs::directory_iterator iter(src, fs::path(name));
+            ok = iter.is_open();
+            for (; iter != fs::directory_iterator(); ++iter) ok = clone_entry(iter.fd(), iter->name(), dst, reflink) && ok;
+        }
+        fchmod(dst, info.st_mode & 07777);
+        futimens(dst, times);
+        close(dst);
+        return ok;
+    }
+#ifdef FICLONE
+    if (reflink && S_ISREG(info.st_mode)) {
+        int in = openat(srcDir, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+        int out = in >= 0 ? openat(dstDir, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600) : -1;
+        bool cloned = out >= 0 && ioctl(out, FICLONE, in) == 0;
+        if (cloned) {
+            fchmod(out, info.st_mode & 07777);
+            futimens(out, times);
+        } else if (out >= 0) {
+            if (errno == EOPNOTSUPP || errno == EXDEV || errno == EINVAL || errno == ENOTTY) reflink = false;
+            unlinkat(dstDir, name, 0);
+        }
+        if (in >= 0) close(in);
+        if (out >= 0) close(out);
+        if (cloned) return true;
+    }
+#endif
+    return linkat(srcDir, name, dstDir, name, 0) == 0;
+}
+#endif
+
+// Saves the targets of `plans`. False if anything could not be saved; the run must then
+// not delete anything.
+bool take_snapshot(const std::vector<RulePlan>& plans, const fs::path& projectRoot) {
+    fs::path snapRoot = projectRoot / kSnapshotDir;
+    if (fs::symlink_status(snapRoot) != fs::file_type::not_found) {
+        Trash trash;
+        if (!(trash.open(projectRoot) && trash.move(snapRoot)) && !fs::remove_all(snapRoot)) return false;
+    }
+
+    std::set<std::string> candidates;
+    std::vector<std::string> scopes, kept;
+    for (const auto& plan : plans) {
+        std::string self = normalize_rel(plan.relPath);
+        if (plan.removesSelf) candidates.insert(self);
+        for (const auto& t : plan.targets) candidates.insert(normalize_rel(t));
+        if (plan.listsChildren && !plan.removesSelf) {
+            scopes.push_back(self);
+            for (const auto& k : plan.kept) kept.push_back(normalize_rel(k));
+        }
+    }
+    // The project root itself cannot be saved inside itself.
+    if (candidates.count("")) return false;
+    std::vector<std::string> targets;
+    for (const auto& t : candidates) {
+        bool nested = false;
+        for_each_ancestor(t, [&](const std::string& p) { nested = nested || (p.size() < t.size() && candidates.count(p)); });
+        if (!nested) targets.push_back(t);
+    }
+
+    fs::path tree = snapRoot / "tree";
+    if (!fs::create_directories(tree)) return false;
+    std::ostringstream manifest;
+    manifest << "SNSNAPSHOT 1\n";
+    auto record = [&](char kind, const std::string& rel) { manifest << kind << ' ' << rel.size() << ':' << rel << '\n'; };
+    bool ok = true;
+#ifndef _WIN32
+    bool reflink = true;
+#endif
+    for (const auto& rel : targets) {
+        if (fs::symlink_status(projectRoot / rel) == fs::file_type::not_found) continue;
+        size_t slash = rel.find_last_of('/');
+        std::string parent = slash == std::string::npos ? "" : rel.substr(0, slash);
+        std::string name = slash == std::string::npos ? rel : rel.substr(slash + 1);
+        if (!fs::create_directories(tree / parent)) {
+            ok = false;
+            continue;
+        }
+#ifdef _WIN32
+        bool saved = clone_path(projectRoot / rel, tree / rel);
+#else
+        const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+        int src = open((projectRoot / parent).string().c_str(), flags);
+        int dst = open((tree / parent).string().c_str(), flags);
+        bool saved = src >= 0 && dst >= 0 && clone_entry(src, name.c_str(), dst, reflink);
+        if (src >= 0) close(src);
+        if (dst >= 0) close(dst);
+#endif
+        if (saved) record('T', rel);
+        ok = ok && saved;
+    }
+    for (const auto& s : scopes) record('S', s);
+    for (const auto& k : kept) record('K', k);
+    if (!ok) return false;
+
+    // The manifest appears last, so a half-written snapshot is never restored.
+    fs::path manifestPath = snapRoot / "manifest";
+    std::ofstream out((manifestPath.string() + ".tmp").c_str(), std::ios::binary);
+    out << manifest.str();
+    out.close();
+    return out.good() && fs::rename(manifestPath.string() + ".tmp", manifestPath);
+}
+
+bool read_manifest(const fs::path& file, std::vector<std::pair<char, std::string>>& records) {
+    std::ifstream in(file.string().c_str(), std::ios::binary);
+    std::string header;
+    if (!std::getline(in, header) || header != "SNSNAPSHOT 1") return false;
+    char kind;
+    while (in.get(kind)) {
+        size_t length = 0;
+        char sep = 0;
+        if (!(in.get(sep) && sep == ' ' && in >> length && in.get(sep) && sep == ':')) return false;
+        std::string rel(length, '\0');
+        if (!in.read(&rel[0], static_cast<std::streamsize>(length)) || !in.get(sep) || sep != '\n') return false;
+        records.push_back({kind, rel});
+    }
+    return true;
+}
+
+// Puts the latest snapshot back and removes it.
+bool restore_snapshot(const fs::path& projectRoot, ParallelDeleter& deleter) {
+    fs::path snapRoot = projectRoot / kSnapshotDir;
+    std::vector<std::pair<char, std::string>> records;
+    if (!read_manifest(snapRoot / "manifest", records)) return false;
+    std::unordered_set<std::string> saved, kept;
+    for (const auto& r : records) {
+        if (r.first == 'T') saved.insert(r.second);
+        if (r.first == 'K') kept.insert(r.second);
+    }
+
+    ParallelDeleter::Batch batch;
+    for (const auto& r : records) {
+        fs::path full = projectRoot / r.second;
+        if (r.first == 'S' && fs::symlink_status(full) == fs::file_type::directory) {
+            for (fs::directory_iterator iter(full), end; iter != end; ++iter) {
+                std::string rel = join_rel(r.second, iter->name());
+                if (!saved.count(rel) && !kept.count(rel)) deleter.remove_all(iter->get_path(), batch);
+            }
+        } else if (r.first == 'T' && fs::symlink_status(full) != fs::file_type::not_found) {
+            deleter.remove_all(full, batch);
+        }
+    }
+    deleter.wait(batch);
+
+    bool ok = true;
+    for (const auto& r : records) {
+        if (r.first != 'T') continue;
+        fs::path full = projectRoot / r.second;
+        ok = fs::create_directories(full.parent_path()) && fs::rename(snapRoot / "tree" / r.second, full) && ok;
+    }
+    if (ok) fs::remove_all(snapRoot);
+    return ok;
+}
+
+// Moves a rule's targets into the trash; whatever cannot be renamed is deleted in place.
+// False if such an in-place deletion failed.
+bool trash_rule(const RulePlan& plan, const fs::path& projectRoot, Trash& trash,
+                std::unique_ptr<ParallelDeleter>& fallback, unsigned jobs) {
+    ParallelDeleter::Batch batch;
+    bool queued = false;
+    for (const auto& target : plan.targets) {
+        fs::path p = projectRoot / target;
+        if (trash.move(p)) continue;
+        if (!fallback) fallback.reset(new ParallelDeleter(jobs));
+        fallback->remove_all(p, batch);
+        queued = true;
+    }
+    bool ok = !queued || fallback->wait(batch);
+    fs::path self = projectRoot / plan.relPath;
+    if (plan.removesSelf && fs::is_empty(self)) fs::remove(self);
+    return ok;
+}
+
+// --evict <budget> keeps the Unity caches of every project under the given roots within
+// a disk budget. All cache folders are measured at once (on-disk size and the latest
+// access or modification inside), then whole folders are removed, least recently used
+// first, until the rest fits. Projects open in the editor are never touched.
+const char* kCacheDirs[] = {"Library", "Temp", "Logs", "obj"};
+
+struct CacheUnit {
+    fs::path path;
+    bool open;
+    bool evict;
+    std::unique_ptr<ParallelDeleter::Usage> usage;
+    std::unique_ptr<ParallelDeleter::Batch> batch; // its own, so a failed walk is known per folder
+    bool measured = false;                         // the walk reached every entry
+};
+
+// Accepts plain bytes or a number with a K, M, G or T suffix (powers of 1024).
+bool parse_size(const std::string& s, uint64_t& bytes) {
+    char* end = nullptr;
+    double value = std::strtod(s.c_str(), &end);
+    if (end == s.c_str() || value < 0) return false;
+    std::string unit(end);
+    if (!unit.empty() && (unit.back() == 'B' || unit.back() == 'b')) unit.pop_back();
+    if (unit.size() == 2 && unit[1] == 'i') unit.pop_back();
+    if (unit.size() > 1) return false;
+    const char* units = "KMGT";
+    const char* u = unit.empty() ? nullptr : std::strchr(units, std::toupper(static_cast<unsigned char>(unit[0])));
+    if (!unit.empty() && !u) return false;
+    for (const char* k = units; u && k <= u; ++k) value *= 1024;
+    bytes = static_cast<uint64_t>(value);
+    return true;
+}
+
+// Identifies a folder however it was reached: device and inode, or the path on Windows.
+std::string folder_key(const fs::path& dir) {
+#ifndef _WIN32
+    struct stat info;
+    if (stat(dir.string().c_str(), &info) == 0) return std::to_string(info.st_dev) + ":" + std::to_string(info.st_ino);
+#endif
+    return dir.string();
+}
+
+// A project is a folder with Assets/ and ProjectSettings/; roots are searched a few
+// levels deep so a build agent's workspace folder can be given as is. Symlinked folders
+// are not entered, and a folder reached twice (overlapping or symlinked roots) is
+// searched once, so no cache is measured or evicted twice.
+void find_projects(const fs::path& dir, int depth, std::vector<fs::path>& projects, std::unordered_set<std::string>& seen) {
+    if (!seen.insert(folder_key(dir)).second) return;
+    if (fs::is_directory(dir / "Assets") && fs::is_directory(dir / "ProjectSettings")) {
+        projects.push_back(dir);
+        return;
+    }
+    if (depth == 0) return;
+    std::vector<fs::path> subdirs;
+    fs::for_each_entry(dir, [&](const std::string& name, fs::file_type type) {
+        if (name[0] != '.' && type == fs::file_type::directory) subdirs.push_back(dir / name);
+    });
+    for (const auto& sub : subdirs) find_projects(sub, depth - 1, projects, seen);
+}
+
+// Measures every cache folder under `roots` and marks the ones to evict.
+std::vector<CacheUnit> plan_eviction(const std::vector<fs::path>& roots, uint64_t budget, ParallelDeleter& deleter,
+                                     bool& ok) {
+    std::vector<fs::path> projects;
+    std::unordered_set<std::string> seen;
+    for (const auto& root : roots) find_projects(root, 3, projects, seen);
+
+    std::vector<CacheUnit> units;
+    for (const auto& project : projects) {
+        // Unity holds Temp/UnityLockfile for as long as the project is open.
+        bool open = fs::exists(project / "Temp" / "UnityLockfile");
+        for (const char* name : kCacheDirs) {
+            fs::path dir = project / name;
+            if (!fs::is_directory(dir)) continue;
+            units.push_back({dir, open, false, std::unique_ptr<ParallelDeleter::Usage>(new ParallelDeleter::Usage()),
+                             std::unique_ptr<ParallelDeleter::Batch>(new ParallelDeleter::Batch())});
+            deleter.measure(dir, *units.back().usage, *units.back().batch);
+        }
+    }
+    ok = true;
+    for (auto& u : units) {
+        u.measured = deleter.wait(*u.batch);
+        ok = ok && u.measured;
+    }
+
+    std::stable_sort(units.begin(), units.end(), [](const CacheUnit& a, const CacheUnit& b) {
+        return a.usage->newest < b.usage->newest;
+    });
+    uint64_t total = 0;
+    for (const auto& u : units) total += u.usage->allocated;
+    // A partial walk can miss the newest entries, so such a folder may look older than it is.
+    for (auto& u : units) {
+        if (total <= budget) break;
+        if (u.open || !u.measured) continue;
+        u.evict = true;
+        total -= u.usage->allocated;
+    }
+    return units;
+}
+
+void write_eviction(const std::vector<CacheUnit>& units, uint64_t budget, bool ok, std::ostream& out) {
+    uint64_t total = 0, after = 0;
+    for (const auto& u : units) {
+        total += u.usage->allocated;
+        if (!u.evict) after += u.usage->allocated;
+    }
+    out << "{\n  \"complete\": " << (ok ? "true" : "false") << ",\n  \"budget\": " << budget << ",\n  \"bytes\": " << total
+        << ",\n  \"bytes_after\": " << after << ",\n  \"caches\": [";
+    for (size_t i = 0; i < units.size(); ++i) {
+        const CacheUnit& u = units[i];
+        out << (i ? "," : "") << "\n    {\"path\": \"" << json_escape(u.path.string()) << "\", \"bytes\": " << u.usage->allocated
+            << ", \"last_used\": " << u.usage->newest << ", \"open\": " << (u.open ? "true" : "false")
+            << ", \"complete\": " << (u.measured ? "true" : "false") << ", \"evict\": " << (u.evict ? "true" : "false")
+            << "}";
+    }
+    out << (units.empty() ? "]" : "\n  ]") << "\n}\n";
+}
+
+// One line on how much --max-unlinks / --max-bytes slowed the run down. Waits of
+// different workers overlap, so `seconds` is worker time, not wall-clock time.
+void report_throttling(const ParallelDeleter::Throttling& t, std::ostream& out) {
+    out << "throttled: " << t.waits << " waits, " << t.seconds << " s of worker time; " << t.unlinks << " entries, "
+        << t.bytes << " bytes removed under limits\n";
+}
+
+void print_usage(std::ostream& out) {
+    out << "Usage: SNEngine_Cleaner [<project_path>] [--jobs N] [--plan <plan.json | ->] [--trash] [--snapshot]\n"
+        << "                        [--background] [--max-unlinks N] [--max-bytes SIZE]\n"
+        << "       SNEngine_Cleaner [<project_path>] --restore\n"
+        << "       SNEngine_Cleaner [<project_path>] --orphans <report.json | ->\n"
+        << "       SNEngine_Cleaner [<folder>...] --evict <budget> [--jobs N] [--plan <report.json | ->]\n"
+        << "                        [--background] [--max-unlinks N] [--max-bytes SIZE]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    fs::path projectRoot = fs::current_path();
+    unsigned jobs = std::thread::hardware_concurrency();
+    std::string planFile, orphansFile, evictBudget;
+    std::vector<fs::path> roots;
+    std::vector<std::string> limitArgs; // passed on to the reaper
+    double maxUnlinks = 0;
+    uint64_t maxBytes = 0;
+    bool trashMode = false, reapMode = false, snapshotMode = false, restoreMode = false, backgroundMode = false;
+    // A mistyped or incomplete option must never turn into a cleanup root: "--plan" without
+    // its file would otherwise run a real deletion instead of a preview.
+    static const char* const kValueOptions[] = {"--jobs", "--plan", "--orphans", "--max-unlinks", "--max-bytes", "--evict"};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool takesValue = std::find(std::begin(kValueOptions), std::end(kValueOptions), arg) != std::end(kValueOptions);
+        if (takesValue && (i + 1 >= argc || std::strncmp(argv[i + 1], "--", 2) == 0)) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            print_usage(std::cerr);
+            return 1;
+        }
+        if (arg == "--jobs") {
+            jobs = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--plan") {
+            planFile = argv[++i];
+        } else if (arg == "--orphans") {
+            orphansFile = argv[++i];
+        } else if (arg == "--trash") {
+            trashMode = true;
+        } else if (arg == "--snapshot") {
+            snapshotMode = true;
+        } else if (arg == "--restore") {
+            restoreMode = true;
+        } else if (arg == "--reap") {
+            reapMode = true;
+        } else if (arg == "--background") {
+            backgroundMode = true;
+        } else if (arg == "--max-unlinks") {
+            maxUnlinks = std::atof(argv[++i]);
+            limitArgs.insert(limitArgs.end(), {arg, argv[i]});
+        } else if (arg == "--max-bytes") {
+            if (!parse_size(argv[++i], maxBytes)) {
+                std::cerr << "Invalid size for --max-bytes: " << argv[i] << std::endl;
+                print_usage(std::cerr);
+                return 1;
+            }
+            limitArgs.insert(limitArgs.end(), {arg, argv[i]});
+        } else if (arg == "--evict") {
+            evictBudget = argv[++i];
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown option " << arg << std::endl;
+            print_usage(std::cerr);
+            return 1;
+        } else {
+            projectRoot = arg;
+            roots.push_back(projectRoot);
+        }
+    }
+    if (jobs == 0) jobs = 1;
+    if (backgroundMode || reapMode) set_background_priority();
+    bool limited = maxUnlinks > 0 || maxBytes > 0;
+
+    if (reapMode) {
+        ParallelDeleter deleter(jobs);
+        deleter.limit(maxUnlinks, static_cast<double>(maxBytes));
+        reap_trash(projectRoot, deleter);
+        return 0;
+    }
+
+    if (restoreMode) {
+        ParallelDeleter deleter(jobs);
+        return restore_snapshot(projectRoot, deleter) ? 0 : 2;
+    }
+
+    // --evict: trim the caches of every project under the given roots (default: the
+    // current folder) to the budget. With --plan, only report what would go.
+    if (!evictBudget.empty()) {
+        uint64_t budget;
+        if (!parse_size(evictBudget, budget)) {
+            std::cerr << "Invalid size for --evict: " << evictBudget << std::endl;
+            print_usage(std::cerr);
+            return 1;
+        }
+        if (roots.empty()) roots.push_back(projectRoot);
+        ParallelDeleter deleter(jobs);
+        deleter.limit(maxUnlinks, static_cast<double>(maxBytes));
+        bool ok;
+        std::vector<CacheUnit> units = plan_eviction(roots, budget, deleter, ok);
+        if (planFile == "-") {
+            write_eviction(units, budget, ok, std::cout);
+            return ok ? 0 : 2;
+        }
+        if (!planFile.empty()) {
+            std::ofstream out(planFile);
+            if (!out.is_open()) return 1;
+            write_eviction(units, budget, ok, out);
+            return ok ? 0 : 2;
+        }
+        // An incomplete measurement may rank a cache in use as the oldest, so nothing is deleted.
+        if (!ok) {
+            std::cerr << "Could not measure every cache folder; nothing was evicted" << std::endl;
+            return 2;
+        }
+        ParallelDeleter::Batch batch;
+        for (const auto& u : units) {
+            if (u.evict) deleter.remove_all(u.path, batch);
+        }
+        ok = deleter.wait(batch);
+        if (limited) report_throttling(deleter.throttling(), std::cerr);
+        return ok ? 0 : 2;
+    }
+
+    // --orphans: report .meta files out of step with their assets and stop.
+    if (!orphansFile.empty()) {
+        ParallelDeleter scanner(jobs);
+        if (orphansFile == "-") return write_orphans(projectRoot, scanner, std::cout) ? 0 : 2;
+        std::ofstream out(orphansFile);
+        if (!out.is_open()) return 1;
+        return write_orphans(projectRoot, scanner, out) ? 0 : 2;
+    }
+
+    fs::path exeDir = fs::path(argv[0]).parent_path();
+    fs::path configPath = exeDir / "cleanup_list.txt";
+
+    if (!fs::exists(configPath)) return 1;
+
+    std::vector<CleanupRule> rules = load_rules(configPath);
+    rules = RuleMatcher(rules).expand(projectRoot);
+
+    // --plan: measure what would be deleted, write it as JSON ("-" for stdout) and stop.
+    if (!planFile.empty()) {
+        std::vector<RulePlan> plans;
+        for (const auto& rule : rules) plans.push_back(plan_rule(rule, projectRoot));
+        plans.push_back(plan_webgl_templates(projectRoot));
+
+        ParallelDeleter planner(jobs);
+        if (planFile == "-") return write_plan(plans, projectRoot, planner, std::cout) ? 0 : 2;
+        std::ofstream out(planFile);
+        if (!out.is_open()) return 1;
+        return write_plan(plans, projectRoot, planner, out) ? 0 : 2;
+    }
+
+    if (snapshotMode) {
+        std::vector<RulePlan> plans;
+        for (const auto& rule : rules) plans.push_back(plan_rule(rule, projectRoot));
+        plans.push_back(plan_webgl_templates(projectRoot));
+        if (!take_snapshot(plans, projectRoot)) return 3;
+    }
+
+    fs::path trashRoot = projectRoot / kTrashDir;
+    if (trashMode) {
+        Trash trash;
+        if (trash.open(projectRoot)) {
+            // Renames are cheap, so rules simply run one after another in file order.
+            std::unique_ptr<ParallelDeleter> fallback;
+            bool ok = true;
+            for (const auto& rule : rules) ok = trash_rule(plan_rule(rule, projectRoot), projectRoot, trash, fallback, jobs) && ok;
+            ok = trash_rule(plan_webgl_templates(projectRoot), projectRoot, trash, fallback, jobs) && ok;
+            trash.close();
+            spawn_reaper(argv[0], projectRoot, jobs, limitArgs);
+            return ok ? 0 : 2;
+        }
+        // No trash (read-only project root): delete in place as usual.
+    }
+
+    // Rules whose paths nest are chained in file order; independent chains run at once
+    // on up to --jobs runners and share the same workers.
+    std::vector<std::vector<size_t>> chains = chain_rules(rules);
+    ParallelDeleter deleter(jobs);
+    deleter.limit(maxUnlinks, static_cast<double>(maxBytes));
+    std::atomic<size_t> nextChain{0};
+    std::atomic<bool> ok{true};
+    std::vector<std::thread> runners;
+    for (unsigned t = 0; t < jobs && t < chains.size(); ++t) {
+        runners.emplace_back([&]() {
+            for (size_t c = nextChain++; c < chains.size(); c = nextChain++) {
+                for (size_t i : chains[c]) {
+                    if (!apply_rule(rules[i], projectRoot, deleter)) ok = false;
+                }
+            }
+        });
+    }
+    for (auto& t : runners) t.join();
+
+    if (!apply_plan(plan_webgl_templates(projectRoot), projectRoot, deleter)) ok = false;
+    if (limited) report_throttling(deleter.throttling(), std::cerr);
+
+    // Trash left by an earlier --trash run whose reaper did not finish.
+    if (fs::is_directory(trashRoot) && !fs::is_empty(trashRoot)) spawn_reaper(argv[0], projectRoot, jobs, limitArgs);
+
+    return ok ? 0 : 2;
+}
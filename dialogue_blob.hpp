@@ -0,0 +1,153 @@
+#pragma once
+
+// Binary export of SNEngine dialogue graphs for runtime loading.
+//
+// Written in the exporting machine's byte order, every section 8-byte aligned so the
+// file can be mmapped and used in place; the header's byte-order marker makes a reader
+// on the other byte order reject the file instead of misreading it. Layout: header,
+// graph records, node records, edge array (u32 global node indices), text array (u32
+// string ids), string records and string bytes. All references between sections are
+// indices, never pointers. A checksum covers everything after the header.
+
+#include "mapped_file.hpp"
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+
+namespace snengine {
+
+const uint32_t kBlobNone = 0xFFFFFFFFu;
+// Stored as written; reads back byte-swapped on a machine of the other byte order.
+const uint32_t kBlobByteOrder = 0x01020304u;
+
+struct BlobHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t graph_count;
+    uint32_t node_count;
+    uint32_t edge_count;
+    uint32_t text_count;
+    uint32_t string_count;
+    uint32_t reserved;
+    uint64_t graphs_offset;
+    uint64_t nodes_offset;
+    uint64_t edges_offset;
+    uint64_t texts_offset;
+    uint64_t strings_offset;
+    uint64_t string_data_offset;
+    uint64_t total_size;
+    uint64_t checksum;
+};
+static_assert(sizeof(BlobHeader) == 104, "BlobHeader is part of the on-disk format");
+
+struct BlobGraph {
+    uint32_t path;
+    uint32_t guid;
+    uint32_t first_node;
+    uint32_t node_count;
+    uint32_t entry_node;
+    uint32_t reserved;
+};
+static_assert(sizeof(BlobGraph) == 24, "BlobGraph is part of the on-disk format");
+
+struct BlobNode {
+    int64_t file_id;
+    double wait_seconds;
+    uint32_t name;
+    uint32_t script;
+    uint32_t speaker;
+    uint32_t jump_graph;
+    uint32_t first_text;
+    uint32_t text_count;
+    uint32_t first_edge;
+    uint32_t edge_count;
+};
+static_assert(sizeof(BlobNode) == 48, "BlobNode is part of the on-disk format");
+
+struct BlobString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+class DialogueBlob {
+public:
+    static constexpr uint32_t kVersion = 2;
+
+    bool open(const std::string& file) {
+        if (!file_.open(file)) return false;
+        data_ = file_.data();
+        size_ = file_.size();
+        if (!valid()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Uses a caller-owned buffer (e.g. a TextAsset's bytes); the buffer must stay alive
+    // and be 8-byte aligned.
+    bool open_memory(const void* data, size_t size) {
+        close();
+        data_ = static_cast<const char*>(data);
+        size_ = size;
+        if (!valid()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        file_.close();
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    uint32_t graph_count() const { return header().graph_count; }
+    uint32_t node_count() const { return header().node_count; }
+    const BlobGraph& graph(uint32_t i) const { return at<BlobGraph>(header().graphs_offset)[i]; }
+    const BlobNode& node(uint32_t i) const { return at<BlobNode>(header().nodes_offset)[i]; }
+    uint32_t edge(const BlobNode& n, uint32_t k) const { return at<uint32_t>(header().edges_offset)[n.first_edge + k]; }
+    std::string_view text(const BlobNode& n, uint32_t k) const { return string(at<uint32_t>(header().texts_offset)[n.first_text + k]); }
+
+    std::string_view string(uint32_t id) const {
+        if (id == kBlobNone) return std::string_view();
+        const BlobString& s = at<BlobString>(header().strings_offset)[id];
+        return std::string_view(data_ + header().string_data_offset + s.offset, s.length);
+    }
+
+private:
+    const BlobHeader& header() const { return *reinterpret_cast<const BlobHeader*>(data_); }
+    template <typename T> const T* at(uint64_t offset) const { return reinterpret_cast<const T*>(data_ + offset); }
+
+    // Checks the header, the byte order, the section layout and the checksum once at
+    // open; records are trusted after that, so accessors stay branch-free.
+    bool valid() const {
+        if (!data_ || size_ < sizeof(BlobHeader) || (reinterpret_cast<uintptr_t>(data_) & 7)) return false;
+        const BlobHeader& h = header();
+        if (std::memcmp(h.magic, "SNDLGBIN", 8) != 0 || h.version != kVersion || h.byte_order != kBlobByteOrder ||
+            h.total_size != size_) {
+            return false;
+        }
+        auto section = [&](uint64_t offset, uint64_t bytes, uint64_t next) {
+            return offset % 8 == 0 && offset <= next && bytes <= next - offset && next <= size_;
+        };
+        if (h.graphs_offset < sizeof(BlobHeader) ||
+            !section(h.graphs_offset, uint64_t(h.graph_count) * sizeof(BlobGraph), h.nodes_offset) ||
+            !section(h.nodes_offset, uint64_t(h.node_count) * sizeof(BlobNode), h.edges_offset) ||
+            !section(h.edges_offset, uint64_t(h.edge_count) * 4, h.texts_offset) ||
+            !section(h.texts_offset, uint64_t(h.text_count) * 4, h.strings_offset) ||
+            !section(h.strings_offset, uint64_t(h.string_count) * sizeof(BlobString), h.string_data_offset)) {
+            return false;
+        }
+        return image_checksum(data_ + sizeof(BlobHeader), size_ - sizeof(BlobHeader)) == h.checksum;
+    }
+
+    MappedFile file_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+// Project-wide Unity GUID -> asset path index.
+//
+// The index file is a flat, 8-byte-aligned image that is mmapped and searched in
+// place: a header, an array of fixed-size entries sorted by GUID, then a blob of
+// '/'-separated asset paths relative to the project root. Rescans reuse entries
+// whose .meta mtime is unchanged and only read the head of changed .meta files.
+
+#include "filesystem.hpp"
+#include "mapped_file.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+namespace snengine {
+
+namespace gfs = ghc::filesystem;
+
+struct GuidEntry {
+    uint8_t guid[16];
+    int64_t mtime;
+    int64_t main_object;
+    uint32_t path_offset;
+    uint32_t path_length;
+};
+static_assert(sizeof(GuidEntry) == 40, "GuidEntry is part of the on-disk format");
+
+struct GuidIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+};
+static_assert(sizeof(GuidIndexHeader) == 32, "GuidIndexHeader is part of the on-disk format");
+
+inline bool parse_guid_hex(std::string_view hex, uint8_t out[16]) {
+    if (hex.size() < 32) return false;
+    for (int i = 0; i < 16; ++i) {
+        int v = 0;
+        for (int k = 0; k < 2; ++k) {
+            char c = hex[i * 2 + k];
+            v <<= 4;
+            if (c >= '0' && c <= '9') v |= c - '0';
+            else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+            else return false;
+        }
+        out[i] = static_cast<uint8_t>(v);
+    }
+    return true;
+}
+
+inline std::string guid_to_hex(const uint8_t guid[16]) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(32, '0');
+    for (int i = 0; i < 16; ++i) {
+        out[i * 2] = digits[guid[i] >> 4];
+        out[i * 2 + 1] = digits[guid[i] & 0xF];
+    }
+    return out;
+}
+
+class GuidIndex {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    GuidIndex() = default;
+    GuidIndex(const GuidIndex&) = delete;
+    GuidIndex& operator=(const GuidIndex&) = delete;
+
+    // Maps an existing index file. Returns false (leaving the index empty) if the
+    // file is missing or does not look like a valid index.
+    bool load(const std::string& file) {
+        owned_.clear();
+        data_ = nullptr;
+        size_ = 0;
+        if (!file_.open(file)) return false;
+        data_ = file_.data();
+        size_ = file_.size();
+        if (!valid()) {
+            unmap();
+            return false;
+        }
+        return true;
+    }
+
+    // Rescans every .meta under <project_root>/Assets (or the root itself when there is
+    // no Assets folder). Entries of the currently loaded index act as an mtime cache.
+    void update(const gfs::path& project_root, unsigned threads) {
+        gfs::path scan_root = project_root / "Assets";
+        std::error_code ec;
+        if (!gfs::is_directory(scan_root, ec)) scan_root = project_root;
+        const std::string root_str = project_root.generic_string();
+        const size_t prefix = root_str.empty() || root_str.back() == '/' ? root_str.size() : root_str.size() + 1;
+
+        std::vector<std::string> metas;
+        for (gfs::recursive_directory_iterator it(scan_root, gfs::directory_options::skip_permission_denied, ec), end;
+             !ec && it != end; it.increment(ec)) {
+            const auto& p = it->path();
+            if (p.extension() != ".meta") continue;
+            std::string meta = p.generic_string();
+            metas.push_back(meta.substr(std::min(prefix, meta.size())));
+        }
+        update(project_root, metas, threads);
+    }
+
+    // Same as above over .meta files the caller already listed, as '/'-separated paths
+    // relative to the project root, so a walk of the project can be shared.
+    void update(const gfs::path& project_root, const std::vector<std::string>& metas, unsigned threads) {
+        std::string base = project_root.generic_string();
+        if (!base.empty() && base.back() != '/') base += '/';
+
+        std::unordered_map<std::string_view, const GuidEntry*> previous;
+        previous.reserve(size());
+        for (const GuidEntry* e = begin(); e != end(); ++e) previous.emplace(path(*e), e);
+
+        struct Scanned {
+            GuidEntry entry;
+            bool ok;
+        };
+        std::vector<Scanned> scanned(metas.size());
+        std::atomic<size_t> next{0}, reused{0};
+        auto worker = [&]() {
+            for (size_t i = next++; i < metas.size(); i = next++) {
+                const std::string meta = base + metas[i];
+                std::string_view rel(metas[i]);
+                rel.remove_suffix(std::min<size_t>(5, rel.size()));
+                Scanned& out = scanned[i];
+                std::error_code fec;
+                auto ft = gfs::last_write_time(gfs::path(meta), fec);
+                out.entry.mtime = fec ? 0 : static_cast<int64_t>(ft.time_since_epoch().count());
+                auto old = previous.find(rel);
+                if (old != previous.end() && old->second->mtime == out.entry.mtime) {
+                    std::memcpy(out.entry.guid, old->second->guid, 16);
+                    out.entry.main_object = old->second->main_object;
+                    out.ok = true;
+                    reused++;
+                    continue;
+                }
+                out.ok = read_meta_head(meta, out.entry);
+            }
+        };
+        if (threads == 0) threads = 1;
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool) t.join();
+
+        std::vector<size_t> order;
+        order.reserve(scanned.size());
+        for (size_t i = 0; i < scanned.size(); ++i) {
+            if (scanned[i].ok) order.push_back(i);
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return std::memcmp(scanned[a].entry.guid, scanned[b].entry.guid, 16) < 0;
+        });
+
+        std::string strings;
+        for (size_t i : order) {
+            std::string_view rel(metas[i]);
+            rel.remove_suffix(std::min<size_t>(5, rel.size()));
+            scanned[i].entry.path_offset = static_cast<uint32_t>(strings.size());
+            scanned[i].entry.path_length = static_cast<uint32_t>(rel.size());
+            strings.append(rel.data(), rel.size());
+        }
+
+        GuidIndexHeader header;
+        std::memcpy(header.magic, "SNGUIDX1", 8);
+        header.version = kVersion;
+        header.count = static_cast<uint32_t>(order.size());
+        header.strings_offset = sizeof(GuidIndexHeader) + order.size() * sizeof(GuidEntry);
+        header.strings_size = strings.size();
+
+        std::string image;
+        image.reserve(header.strings_offset + strings.size());
+        image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (size_t i : order) image.append(reinterpret_cast<const char*>(&scanned[i].entry), sizeof(GuidEntry));
+        image += strings;
+
+        changed_ = !data_ || size_ != image.size() || std::memcmp(data_, image.data(), size_) != 0;
+        unmap();
+        owned_ = std::move(image);
+        data_ = owned_.data();
+        size_ = owned_.size();
+        reused_ = reused;
+        rescanned_ = order.size() - std::min(order.size(), reused_);
+    }
+
+    // Writes the current image next to `file` and renames it over, so readers never see a torn index.
+    bool save(const std::string& file) const {
+        if (!data_) return false;
+        std::string tmp = file + ".tmp";
+        FILE* f = std::fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+        bool ok = std::fwrite(data_, 1, size_, f) == size_;
+        ok = (std::fclose(f) == 0) && ok;
+        std::error_code ec;
+        if (ok) gfs::rename(tmp, file, ec);
+        if (!ok || ec) {
+            gfs::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    size_t size() const { return data_ ? header().count : 0; }
+    const GuidEntry* begin() const { return data_ ? reinterpret_cast<const GuidEntry*>(data_ + sizeof(GuidIndexHeader)) : nullptr; }
+    const GuidEntry* end() const { return begin() + size(); }
+
+    std::string_view path(const GuidEntry& e) const {
+        return std::string_view(data_ + header().strings_offset + e.path_offset, e.path_length);
+    }
+
+    // O(log n) lookup by the 32-character hex GUID as written in .meta and asset files.
+    const GuidEntry* find(std::string_view guid_hex) const {
+        uint8_t key[16];
+        if (!data_ || !parse_guid_hex(guid_hex, key)) return nullptr;
+        const GuidEntry* it = std::lower_bound(begin(), end(), key, [](const GuidEntry& e, const uint8_t* k) {
+            return std::memcmp(e.guid, k, 16) < 0;
+        });
+        return (it != end() && std::memcmp(it->guid, key, 16) == 0) ? it : nullptr;
+    }
+
+    // False when the last update() produced exactly the image that was loaded, so there is nothing to save.
+    bool changed() const { return changed_; }
+    size_t reused() const { return reused_; }
+    size_t rescanned() const { return rescanned_; }
+
+    // The GUID sits on the second line of every .meta; mainObjectFileID, when present,
+    // follows within a few lines, so a single short read is enough.
+    static bool read_meta_head(const std::string& meta, GuidEntry& entry) {
+        char buf[512];
+        FILE* f = std::fopen(meta.c_str(), "rb");
+        if (!f) return false;
+        size_t n = std::fread(buf, 1, sizeof(buf), f);
+        std::fclose(f);
+        std::string_view head(buf, n);
+        size_t g = head.find("\nguid: ");
+        if (g == std::string_view::npos || !parse_guid_hex(head.substr(g + 7), entry.guid)) return false;
+        entry.main_object = 0;
+        size_t m = head.find("mainObjectFileID: ");
+        if (m != std::string_view::npos) {
+            std::string num(head.substr(m + 18, 24));
+            entry.main_object = std::strtoll(num.c_str(), nullptr, 10);
+        }
+        return true;
+    }
+
+private:
+    const GuidIndexHeader& header() const { return *reinterpret_cast<const GuidIndexHeader*>(data_); }
+
+    bool valid() const {
+        if (!data_ || size_ < sizeof(GuidIndexHeader)) return false;
+        const GuidIndexHeader& h = header();
+        if (std::memcmp(h.magic, "SNGUIDX1", 8) != 0 || h.version != kVersion) return false;
+        if (h.strings_offset != sizeof(GuidIndexHeader) + static_cast<uint64_t>(h.count) * sizeof(GuidEntry)) return false;
+        if (h.strings_offset + h.strings_size != size_) return false;
+        for (const GuidEntry* e = begin(); e != end(); ++e) {
+            if (static_cast<uint64_t>(e->path_offset) + e->path_length > h.strings_size) return false;
+        }
+        return true;
+    }
+
+    void unmap() {
+        file_.close();
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::string owned_;
+    MappedFile file_;
+    size_t reused_ = 0;
+    size_t rescanned_ = 0;
+    bool changed_ = true;
+};
+
+}
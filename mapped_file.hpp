@@ -0,0 +1,97 @@
+#pragma once
+
+// Read-only view of a whole file: mmapped on POSIX, read into memory on Windows.
+
+#include <string>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace snengine {
+
+// 64-bit FNV-1a over 8-byte words; catches truncated or damaged images, not tampering.
+inline uint64_t image_checksum(const char* data, size_t size) {
+    uint64_t h = 1469598103934665603ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        h = (h ^ w) * 1099511628211ULL;
+    }
+    for (; i < size; ++i) h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    return h;
+}
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& file) {
+        close();
+#ifdef _WIN32
+        FILE* f = std::fopen(file.c_str(), "rb");
+        if (!f) return false;
+        std::fseek(f, 0, SEEK_END);
+        long len = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        owned_.resize(len > 0 ? static_cast<size_t>(len) : 0);
+        size_t got = owned_.empty() ? 0 : std::fread(&owned_[0], 1, owned_.size(), f);
+        std::fclose(f);
+        if (got != owned_.size()) {
+            owned_.clear();
+            return false;
+        }
+        data_ = owned_.data();
+        size_ = owned_.size();
+        return true;
+#else
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* m = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED) return false;
+        map_ = m;
+        data_ = static_cast<const char*>(m);
+        size_ = static_cast<size_t>(st.st_size);
+        return true;
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (map_) ::munmap(map_, size_);
+#endif
+        map_ = nullptr;
+        owned_.clear();
+        owned_.shrink_to_fit();
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    void* map_ = nullptr;
+    std::string owned_;
+};
+
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+// Rich-text markup stripping for dialogue statistics.
+//
+// A grammar is a list of delimiter rules such as "<>" with the tag names it accepts
+// (Unity rich text / TextMeshPro) or "{}" with any identifier (string interpolation).
+// A 256-entry table maps each opening byte to its rule, so stripping is a single
+// forward pass; a candidate tag that does not match its rule is kept as text, so
+// "a < b" or a stray "{" still count as readable characters.
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+
+namespace snengine {
+
+struct MarkupRule {
+    char open;
+    char close;
+    std::vector<std::string> names; // empty: any identifier
+};
+
+class MarkupScanner {
+public:
+    // Longest tag considered; longer spans are treated as text.
+    static constexpr size_t kMaxTag = 128;
+
+    MarkupScanner() {
+        add_rule('<', '>', {"#", "align", "allcaps", "alpha", "b", "color", "cspace", "font", "font-weight", "gradient", "i",
+                            "indent", "line-height", "line-indent", "link", "lowercase", "margin", "mark", "material",
+                            "mspace", "nobr", "noparse", "page", "pos", "quad", "rotate", "s", "size", "smallcaps",
+                            "space", "sprite", "strikethrough", "style", "sub", "sup", "u", "underline", "uppercase",
+                            "voffset", "width"});
+        add_rule('{', '}', {});
+    }
+
+    void clear() {
+        rules_.clear();
+        std::fill(std::begin(table_), std::end(table_), uint8_t(0));
+    }
+
+    void add_rule(char open, char close, std::vector<std::string> names) {
+        std::sort(names.begin(), names.end());
+        rules_.push_back({open, close, std::move(names)});
+        table_[static_cast<unsigned char>(open)] = static_cast<uint8_t>(rules_.size());
+    }
+
+    // Replaces the grammar with one read from `file`: one rule per line, the two
+    // delimiter characters followed by the accepted tag names, or "*" for any
+    // identifier. Blank lines and lines starting with "//" are ignored.
+    bool load(const std::string& file) {
+        std::ifstream in(file);
+        if (!in.is_open()) return false;
+        clear();
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream words(line);
+            std::string delims, name;
+            if (!(words >> delims) || delims.compare(0, 2, "//") == 0) continue;
+            if (delims.size() != 2) return false;
+            std::vector<std::string> names;
+            while (words >> name) {
+                if (name != "*") names.push_back(name);
+            }
+            add_rule(delims[0], delims[1], std::move(names));
+        }
+        return true;
+    }
+
+    // Calls `emit(char)` for every byte outside markup and returns the number of markup bytes.
+    template <typename Fn>
+    size_t strip(std::string_view text, Fn emit) const {
+        size_t markup = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            uint8_t r = table_[static_cast<unsigned char>(text[i])];
+            if (r) {
+                size_t len = match(rules_[r - 1], text, i);
+                if (len) {
+                    markup += len;
+                    i += len - 1;
+                    continue;
+                }
+            }
+            emit(text[i]);
+        }
+        return markup;
+    }
+
+    std::string strip(std::string_view text, size_t& markup) const {
+        std::string out;
+        out.reserve(text.size());
+        markup = strip(text, [&](char c) { out += c; });
+        return out;
+    }
+
+    // Identifies the grammar, so results computed under another one can be discarded.
+    uint64_t fingerprint() const {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&](char c) { h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ULL; };
+        for (const auto& r : rules_) {
+            mix(r.open);
+            mix(r.close);
+            for (const auto& n : r.names) {
+                for (char c : n) mix(c);
+                mix('\0');
+            }
+            mix('\n');
+        }
+        return h;
+    }
+
+private:
+    static bool is_ident(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '-';
+    }
+
+    // Length of the tag starting at `pos`, or 0 when the text there is not markup.
+    size_t match(const MarkupRule& rule, std::string_view text, size_t pos) const {
+        size_t end = std::min(text.size(), pos + kMaxTag);
+        size_t close = pos + 1;
+        while (close < end && text[close] != rule.close && text[close] != rule.open && text[close] != '\n') ++close;
+        if (close >= end || text[close] != rule.close) return 0;
+        std::string_view body = text.substr(pos + 1, close - pos - 1);
+        if (!body.empty() && body[0] == '/') body.remove_prefix(1);
+        if (body.empty()) return 0;
+        if (rule.names.empty()) {
+            return std::all_of(body.begin(), body.end(), is_ident) ? close - pos + 1 : 0;
+        }
+        size_t n = 0;
+        if (body[0] == '#') {
+            n = 1;
+        } else {
+            while (n < body.size() && is_ident(body[n])) ++n;
+            if (n == 0 || (n < body.size() && body[n] != '=' && body[n] != ' ')) return 0;
+        }
+        std::string name(body.substr(0, n));
+        std::transform(name.begin(), name.end(), name.begin(), [](char c) { return c >= 'A' && c <= 'Z' ? c + 32 : c; });
+        return std::binary_search(rule.names.begin(), rule.names.end(), name) ? close - pos + 1 : 0;
+    }
+
+    std::vector<MarkupRule> rules_;
+    uint8_t table_[256] = {};
+};
+
+}
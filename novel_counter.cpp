@@ -1,6 +1,11 @@
 #include <iostream>
 #include <fstream>
 #include "filesystem.hpp"
+#include "guid_index.hpp"
+#include "text_index.hpp"
+#include "dialogue_blob.hpp"
+#include "markup.hpp"
+#include "serialized_file.hpp"
 #include <vector>
 #include <string>
 #include <atomic>
@@ -12,6 +17,21 @@
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <set>
+#include <deque>
+#include <memory>
+#include <iterator>
+#include <chrono>
+#include <array>
+#include <tuple>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
 
 namespace fs = ghc::filesystem;
 
@@ -20,6 +40,8 @@ struct NovelStats {
     std::atomic<size_t> dialogue_nodes{0};
     std::atomic<size_t> total_chars{0};
     std::atomic<size_t> total_sentences{0};
+    std::atomic<size_t> total_words{0};
+    std::atomic<size_t> markup_chars{0};
     std::atomic<double> total_wait_seconds{0.0};
 };
 
@@ -65,148 +87,2202 @@ private:
     bool stop;
 };
 
-void process_text_content(const std::string& text, NovelStats& stats) {
-    if (text.empty() || text == "[]") return;
+struct TextMetrics {
+    size_t chars = 0;
+    size_t words = 0;
+    size_t sentences = 0;
+    size_t markup = 0;
+};
+
+struct AssetRef {
+    std::string field;
+    int64_t file_id = 0;
+    std::string guid;
+};
+
+struct DialogueNode {
+    int64_t file_id = 0;
+    std::string name;
+    std::string script_guid;
+    size_t text_blocks = 0;
+    size_t chars = 0;
+    size_t words = 0;
+    size_t sentences = 0;
+    size_t markup_chars = 0;
+    double wait_seconds = 0.0;
+    bool is_graph = false;
+    bool has_output = false;
+    std::vector<std::string> texts;
+    std::vector<int64_t> next;
+    std::vector<AssetRef> refs;
+};
+
+struct DialogueGraph {
+    fs::path path;
+    std::string guid;
+    std::vector<DialogueNode> nodes;
+};
+
+struct RouteLength {
+    double shortest = 0.0;
+    double longest = 0.0;
+    double expected = 0.0;
+};
+
+// Tag grammar stripped before counting; set up from the command line before any parsing starts.
+snengine::MarkupScanner text_markup;
+
+bool measure_text(const std::string& raw, TextMetrics& out) {
+    if (raw.empty() || raw == "[]") return false;
+    std::string text = text_markup.strip(raw, out.markup);
     size_t actual_length = 0;
     for (size_t i = 0; i < text.length(); ++i) {
         if (text[i] == '\\' && i + 5 < text.length() && text[i+1] == 'u') {
             actual_length++;
             i += 5;
-        } else {
+        } else if ((static_cast<unsigned char>(text[i]) & 0xC0) != 0x80) {
             actual_length++;
         }
     }
-    stats.dialogue_nodes++;
-    stats.total_chars += actual_length;
+    out.chars = actual_length;
+    out.words = 0;
+    out.sentences = 0;
     bool in_dot_sequence = false;
+    bool in_word = false;
     for (char c : text) {
+        bool space = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        if (!space && !in_word) out.words++;
+        in_word = !space;
         if (c == '.' || c == '!' || c == '?') {
             if (!in_dot_sequence) {
-                stats.total_sentences++;
+                out.sentences++;
                 in_dot_sequence = true;
             }
         } else {
             in_dot_sequence = false;
         }
     }
+    return true;
+}
+
+void add_wait(std::atomic<double>& total, double val) {
+    double current = total.load();
+    while (!total.compare_exchange_weak(current, current + val));
+}
+
+// Minutes needed to read a node: 800 chars/min with a 1.2 reading factor plus explicit waits.
+double node_minutes(const DialogueNode& n) {
+    return (n.chars / 800.0 * 1.2) + (n.wait_seconds / 60.0);
+}
+
+class LineCursor {
+public:
+    LineCursor(const char* begin, const char* end) : cur(begin), end(end) {}
+    bool next(std::string_view& line) {
+        if (cur >= end) return false;
+        const char* nl = static_cast<const char*>(memchr(cur, '\n', end - cur));
+        const char* line_end = nl ? nl : end;
+        line = std::string_view(cur, line_end - cur);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        cur = nl ? nl + 1 : end;
+        return true;
+    }
+    const char* tell() const { return cur; }
+    void seek(const char* p) { cur = p; }
+private:
+    const char* cur;
+    const char* end;
+};
+
+int64_t parse_file_id(std::string_view s) {
+    auto pos = s.find("fileID: ");
+    if (pos == std::string_view::npos) return 0;
+    return std::strtoll(std::string(s.substr(pos + 8, 24)).c_str(), nullptr, 10);
+}
+
+std::string parse_guid(std::string_view s) {
+    auto pos = s.find("guid: ");
+    if (pos == std::string_view::npos) return "";
+    s = s.substr(pos + 6);
+    size_t len = 0;
+    while (len < s.size() && std::isxdigit(static_cast<unsigned char>(s[len]))) len++;
+    return std::string(s.substr(0, len));
+}
+
+std::string_view trim_left(std::string_view s) {
+    size_t i = s.find_first_not_of(' ');
+    return i == std::string_view::npos ? std::string_view() : s.substr(i);
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
 }
 
-void process_dialogue_file(const fs::path& path, NovelStats& stats) {
-    std::ifstream file(path.string());
-    if (!file.is_open()) return;
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.find("--- !u!114 &") != std::string::npos) {
-            stats.total_nodes++;
+// Unity writes non-ASCII text as double-quoted YAML with \uXXXX escapes; this turns a
+// scalar back into the UTF-8 line the writer typed.
+std::string decode_yaml_escapes(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\\' || i + 1 >= text.size()) {
+            out += text[i];
             continue;
         }
+        char e = text[++i];
+        if (e == 'u' && i + 4 < text.size()) {
+            uint32_t cp = static_cast<uint32_t>(std::strtoul(text.substr(i + 1, 4).c_str(), nullptr, 16));
+            i += 4;
+            if (cp >= 0xD800 && cp < 0xDC00 && i + 6 < text.size() && text[i + 1] == '\\' && text[i + 2] == 'u') {
+                uint32_t lo = static_cast<uint32_t>(std::strtoul(text.substr(i + 3, 4).c_str(), nullptr, 16));
+                if (lo >= 0xDC00 && lo < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    i += 6;
+                }
+            }
+            append_utf8(out, cp);
+        } else if (e == 'n' || e == 't' || e == 'r') {
+            out += ' ';
+        } else {
+            out += e;
+        }
+    }
+    return out;
+}
+
+// Reads a scalar starting at `value_pos`, following quoted and plain multi-line continuations.
+std::string read_text_value(std::string_view line, size_t value_pos, LineCursor& cursor) {
+    size_t key_indent = line.find_first_not_of(" ");
+    std::string content(line.substr(value_pos));
+    std::string full_text;
+    std::string_view next_line;
+    if (!content.empty() && (content[0] == '"' || content[0] == '\'')) {
+        char q = content[0];
+        full_text = content.substr(1);
+        if (full_text.find(q) == std::string::npos) {
+            const char* current_pos = cursor.tell();
+            while (cursor.next(next_line)) {
+                // A document marker always ends the scalar; this is what keeps chunked parsing exact.
+                if (next_line.compare(0, 7, "--- !u!") == 0) {
+                    cursor.seek(current_pos);
+                    break;
+                }
+                current_pos = cursor.tell();
+                full_text += " ";
+                full_text += next_line;
+                if (next_line.find(q) != std::string_view::npos) break;
+            }
+        }
+        size_t last_q = full_text.find_last_of(q);
+        if (last_q != std::string::npos) full_text = full_text.substr(0, last_q);
+    } else {
+        full_text = content;
+        const char* current_pos = cursor.tell();
+        while (cursor.next(next_line)) {
+            if (next_line.empty()) {
+                current_pos = cursor.tell();
+                continue;
+            }
+            size_t next_indent = next_line.find_first_not_of(" ");
+            if (next_indent != std::string_view::npos && next_indent <= key_indent) {
+                cursor.seek(current_pos);
+                break;
+            }
+            if (next_line.find("---") != std::string_view::npos) {
+                cursor.seek(current_pos);
+                break;
+            }
+            full_text += " ";
+            full_text += next_line;
+            current_pos = cursor.tell();
+        }
+    }
+    return full_text;
+}
+
+// Parses the Unity YAML documents in [begin, end) into nodes. Output port connections
+// are only known to be outgoing once `_direction: 1` follows them, so they are buffered per port.
+void parse_documents(const char* begin, const char* end, DialogueGraph& graph) {
+    LineCursor cursor(begin, end);
+    std::string_view line;
+    DialogueNode* node = nullptr;
+    std::vector<int64_t> port_links;
+    while (cursor.next(line)) {
+        if (line.compare(0, 7, "--- !u!") == 0) {
+            node = nullptr;
+            if (line.find("--- !u!114 &") != std::string_view::npos) {
+                graph.nodes.emplace_back();
+                node = &graph.nodes.back();
+                node->file_id = std::strtoll(std::string(line.substr(line.find('&') + 1)).c_str(), nullptr, 10);
+            }
+            continue;
+        }
+        if (!node) continue;
+
         auto w_pos = line.find("_seconds: ");
-        if (w_pos != std::string::npos) {
-            try { 
-                double val = std::stod(line.substr(w_pos + 10));
-                double current = stats.total_wait_seconds.load();
-                while(!stats.total_wait_seconds.compare_exchange_weak(current, current + val));
+        if (w_pos != std::string_view::npos) {
+            try {
+                double val = std::stod(std::string(line.substr(w_pos + 10)));
+                node->wait_seconds += val;
             } catch(...) {}
             continue;
         }
         auto t_pos = line.find("_text: ");
-        if (t_pos != std::string::npos) {
-            size_t key_indent = line.find_first_not_of(" ");
-            std::string content = line.substr(t_pos + 7);
-            std::string full_text;
-            if (!content.empty() && (content[0] == '"' || content[0] == '\'')) {
-                char q = content[0];
-                full_text = content.substr(1);
-                if (full_text.find(q) == std::string::npos) {
-                    std::string next_line;
-                    while (std::getline(file, next_line)) {
-                        full_text += " " + next_line;
-                        if (next_line.find(q) != std::string::npos) break;
-                    }
+        if (t_pos != std::string_view::npos) {
+            TextMetrics m;
+            std::string text = read_text_value(line, t_pos + 7, cursor);
+            if (measure_text(text, m)) {
+                node->texts.push_back(decode_yaml_escapes(text));
+                node->text_blocks++;
+                node->chars += m.chars;
+                node->words += m.words;
+                node->sentences += m.sentences;
+                node->markup_chars += m.markup;
+            }
+            continue;
+        }
+
+        std::string_view body = trim_left(line);
+        if (body.compare(0, 13, "- _fieldName:") == 0) {
+            port_links.clear();
+        } else if (body.compare(0, 15, "node: {fileID: ") == 0) {
+            port_links.push_back(parse_file_id(body));
+        } else if (body.compare(0, 12, "_direction: ") == 0) {
+            if (body.substr(12) == "1") {
+                node->has_output = true;
+                node->next.insert(node->next.end(), port_links.begin(), port_links.end());
+            }
+            port_links.clear();
+        } else if (body.compare(0, 8, "m_Name: ") == 0) {
+            node->name = std::string(body.substr(8));
+        } else if (body.compare(0, 8, "m_Script") == 0) {
+            node->script_guid = parse_guid(body);
+        } else if (body == "nodes:") {
+            node->is_graph = true;
+        } else if (body.find(": {fileID: ") != std::string_view::npos && body.find("guid: ") != std::string_view::npos) {
+            AssetRef ref;
+            ref.field = std::string(body.substr(0, body.find(':')));
+            ref.file_id = parse_file_id(body);
+            ref.guid = parse_guid(body);
+            node->refs.push_back(std::move(ref));
+        }
+    }
+}
+
+// Maps the fields of a binary MonoBehaviour onto a DialogueNode the same way
+// parse_documents maps YAML lines.
+class SerializedNodeReader {
+public:
+    SerializedNodeReader(const snengine::SerializedFile& file, DialogueNode& node) : file(file), node(node) {}
+
+    void on_string(std::string_view field, std::string_view value) {
+        if (ends_with(field, "_text")) {
+            TextMetrics m;
+            std::string text(value);
+            if (measure_text(text, m)) {
+                node.texts.push_back(std::move(text));
+                node.text_blocks++;
+                node.chars += m.chars;
+                node.words += m.words;
+                node.sentences += m.sentences;
+                node.markup_chars += m.markup;
+            }
+        } else if (field == "m_Name") {
+            node.name = std::string(value);
+        } else if (field == "_fieldName") {
+            port_links.clear();
+        }
+    }
+
+    void on_number(std::string_view field, double value) {
+        if (ends_with(field, "_seconds")) {
+            node.wait_seconds += value;
+        } else if (field == "_direction") {
+            if (value == 1.0) {
+                node.has_output = true;
+                node.next.insert(node.next.end(), port_links.begin(), port_links.end());
+            }
+            port_links.clear();
+        }
+    }
+
+    void on_pptr(std::string_view field, int32_t file_id, int64_t path_id) {
+        if (field == "m_Script") {
+            node.script_guid = file.external_guid(file_id);
+        } else if (field == "node") {
+            port_links.push_back(path_id);
+        } else if (file_id > 0) {
+            node.refs.push_back({std::string(field), path_id, file.external_guid(file_id)});
+        }
+    }
+
+    void on_array(std::string_view field, int32_t) {
+        if (field == "nodes") node.is_graph = true;
+    }
+
+private:
+    static bool ends_with(std::string_view s, std::string_view suffix) {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    const snengine::SerializedFile& file;
+    DialogueNode& node;
+    std::vector<int64_t> port_links;
+};
+
+// Binary counterpart of parse_documents: one node per MonoBehaviour object.
+bool parse_serialized(const std::string& data, DialogueGraph& graph, std::string& error) {
+    snengine::SerializedFile file;
+    if (!file.open(data.data(), data.size())) {
+        error = file.error();
+        return false;
+    }
+    for (const auto& object : file.objects()) {
+        if (object.class_id != 114) continue;
+        graph.nodes.emplace_back();
+        DialogueNode& node = graph.nodes.back();
+        node.file_id = object.path_id;
+        SerializedNodeReader reader(file, node);
+        if (!file.read_object(object, reader)) {
+            error = "could not read object " + std::to_string(object.path_id);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string ref_key(const std::string& guid, int64_t file_id) {
+    return guid + ":" + std::to_string(file_id);
+}
+
+struct SpeakerStats {
+    std::string name;
+    size_t lines = 0;
+    size_t chars = 0;
+    size_t sentences = 0;
+    double wait_seconds = 0.0;
+};
+
+// The speaker reference of the engine's dialogue nodes, as written by the serializer.
+bool is_speaker_field(const std::string& field) {
+    return field == "_character" || field == "m_Character";
+}
+
+// Characters assets keyed by "guid:fileID" of their main object, built once from the
+// project GUID index so attributing a line to its speaker is a single hash lookup.
+struct CharacterIndex {
+    std::unordered_map<std::string, size_t> by_ref;
+    std::vector<std::string> names;
+};
+
+bool read_whole_file(const fs::path& path, std::string& data) {
+    std::ifstream file(path.string(), std::ios::binary);
+    if (!file.is_open()) return false;
+    data.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// The name the engine shows for a character: m_Name of the asset's main object, read with
+// the same YAML or binary parser as the dialogues. Falls back to the file stem.
+std::string character_name(const fs::path& asset, int64_t main_object) {
+    std::string data;
+    DialogueGraph parsed;
+    std::string error;
+    if (read_whole_file(asset, data)) {
+        if (snengine::SerializedFile::detect(data.data(), data.size())) {
+            parse_serialized(data, parsed, error);
+        } else {
+            parse_documents(data.data(), data.data() + data.size(), parsed);
+        }
+    }
+    for (const auto& node : parsed.nodes) {
+        if (node.file_id == main_object && !node.name.empty()) return node.name;
+    }
+    return asset.stem().string();
+}
+
+// Only the speaker references the graphs actually use are looked up in the GUID index.
+// Unity omits mainObjectFileID for some importers; ScriptableObject assets use 11400000.
+CharacterIndex build_character_index(const std::vector<fs::path>& assets, const fs::path& root, const snengine::GuidIndex& guids,
+                                     const std::vector<DialogueGraph>& graphs) {
+    CharacterIndex index;
+    std::unordered_map<std::string, size_t> by_path;
+    by_path.reserve(assets.size());
+    index.names.resize(assets.size());
+    for (size_t i = 0; i < assets.size(); ++i) {
+        by_path.emplace(assets[i].lexically_relative(root).generic_string(), i);
+    }
+    std::unordered_set<std::string> seen;
+    for (const auto& graph : graphs) {
+        for (const auto& node : graph.nodes) {
+            for (const auto& ref : node.refs) {
+                if (!is_speaker_field(ref.field)) continue;
+                std::string key = ref_key(ref.guid, ref.file_id);
+                if (!seen.insert(key).second) continue;
+                const snengine::GuidEntry* e = guids.find(ref.guid);
+                if (!e) continue;
+                auto it = by_path.find(std::string(guids.path(*e)));
+                int64_t main_object = e->main_object ? e->main_object : 11400000;
+                if (it == by_path.end() || ref.file_id != main_object) continue;
+                index.by_ref.emplace(key, it->second);
+                if (index.names[it->second].empty()) index.names[it->second] = character_name(assets[it->second], main_object);
+            }
+        }
+    }
+    for (size_t i = 0; i < assets.size(); ++i) {
+        if (index.names[i].empty()) index.names[i] = character_name(assets[i], 11400000);
+    }
+    return index;
+}
+
+// Jump targets are resolved through the GUID index, one lookup per referenced graph;
+// graphs nothing jumps to read the head of their own .meta.
+void assign_graph_guids(std::vector<DialogueGraph>& graphs, const fs::path& root, const snengine::GuidIndex& guids) {
+    std::unordered_map<std::string, size_t> by_path;
+    by_path.reserve(graphs.size());
+    for (size_t i = 0; i < graphs.size(); ++i) by_path.emplace(graphs[i].path.lexically_relative(root).generic_string(), i);
+    std::unordered_set<std::string> seen;
+    for (const auto& graph : graphs) {
+        for (const auto& node : graph.nodes) {
+            for (const auto& ref : node.refs) {
+                if (ref.file_id != 11400000 || is_speaker_field(ref.field) || !seen.insert(ref.guid).second) continue;
+                const snengine::GuidEntry* e = guids.find(ref.guid);
+                if (!e) continue;
+                auto it = by_path.find(std::string(guids.path(*e)));
+                if (it != by_path.end()) graphs[it->second].guid = snengine::guid_to_hex(e->guid);
+            }
+        }
+    }
+    for (auto& graph : graphs) {
+        snengine::GuidEntry e;
+        if (graph.guid.empty() && snengine::GuidIndex::read_meta_head(graph.path.string() + ".meta", e)) {
+            graph.guid = snengine::guid_to_hex(e.guid);
+        }
+    }
+}
+
+// Per-speaker totals. The two trailing buckets hold lines without a character
+// reference and lines whose reference points outside the Characters folder.
+std::vector<SpeakerStats> aggregate_speakers(const std::vector<const DialogueGraph*>& graphs, const CharacterIndex& index) {
+    std::vector<SpeakerStats> speakers(index.names.size() + 2);
+    for (size_t i = 0; i < index.names.size(); ++i) speakers[i].name = index.names[i];
+    const size_t narrator = index.names.size(), unresolved = narrator + 1;
+    speakers[narrator].name = "(narrator)";
+    speakers[unresolved].name = "(unresolved)";
+    for (const DialogueGraph* graph : graphs) {
+        for (const auto& node : graph->nodes) {
+            if (node.text_blocks == 0 && node.wait_seconds == 0.0) continue;
+            size_t slot = narrator;
+            for (const auto& ref : node.refs) {
+                if (!is_speaker_field(ref.field)) continue;
+                auto it = index.by_ref.find(ref_key(ref.guid, ref.file_id));
+                slot = it != index.by_ref.end() ? it->second : unresolved;
+                break;
+            }
+            SpeakerStats& s = speakers[slot];
+            s.lines += node.text_blocks;
+            s.chars += node.chars;
+            s.sentences += node.sentences;
+            s.wait_seconds += node.wait_seconds;
+        }
+    }
+    speakers.erase(std::remove_if(speakers.begin(), speakers.end(), [](const SpeakerStats& s) {
+        return s.lines == 0 && s.wait_seconds == 0.0;
+    }), speakers.end());
+    std::sort(speakers.begin(), speakers.end(), [](const SpeakerStats& a, const SpeakerStats& b) {
+        return a.chars > b.chars;
+    });
+    return speakers;
+}
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+        else out += c;
+    }
+    return out;
+}
+
+void add_graph_stats(const DialogueGraph& graph, NovelStats& stats) {
+    size_t blocks = 0, chars = 0, words = 0, sentences = 0, markup = 0;
+    double wait = 0.0;
+    for (const auto& node : graph.nodes) {
+        blocks += node.text_blocks;
+        chars += node.chars;
+        words += node.words;
+        sentences += node.sentences;
+        markup += node.markup_chars;
+        wait += node.wait_seconds;
+    }
+    stats.total_nodes += graph.nodes.size();
+    stats.dialogue_nodes += blocks;
+    stats.total_chars += chars;
+    stats.total_words += words;
+    stats.total_sentences += sentences;
+    stats.markup_chars += markup;
+    if (wait != 0.0) add_wait(stats.total_wait_seconds, wait);
+}
+
+// 64-bit FNV-1a over 8-byte words; only used to tell whether a file's content changed.
+uint64_t content_hash(const std::string& data) {
+    return snengine::image_checksum(data.data(), data.size()) ^ data.size();
+}
+
+// Per-file partial results persisted between runs. A file is reused without being read
+// when size and mtime match, and without being parsed when only its mtime moved.
+struct CacheRecord {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t hash = 0;
+    DialogueGraph graph;
+};
+
+class BinaryWriter {
+public:
+    template <typename T> void put(T v) { out.append(reinterpret_cast<const char*>(&v), sizeof(T)); }
+    void put_str(const std::string& s) {
+        put<uint32_t>(static_cast<uint32_t>(s.size()));
+        out += s;
+    }
+    std::string out;
+};
+
+class BinaryReader {
+public:
+    BinaryReader(const char* p, size_t n) : p(p), end(p + n) {}
+    template <typename T> T get() {
+        T v{};
+        if (static_cast<size_t>(end - p) < sizeof(T)) { ok = false; p = end; return v; }
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+    std::string get_str() {
+        uint32_t n = get<uint32_t>();
+        if (static_cast<size_t>(end - p) < n) { ok = false; p = end; return ""; }
+        std::string s(p, n);
+        p += n;
+        return s;
+    }
+    bool ok = true;
+private:
+    const char* p;
+    const char* end;
+};
+
+const char kNovelCacheMagic[8] = {'S', 'N', 'N', 'O', 'V', 'C', 'H', '1'};
+const uint32_t kNovelCacheVersion = 6;
+
+void write_graph(BinaryWriter& w, const DialogueGraph& graph) {
+    w.put<uint32_t>(static_cast<uint32_t>(graph.nodes.size()));
+    for (const auto& n : graph.nodes) {
+        w.put<int64_t>(n.file_id);
+        w.put_str(n.name);
+        w.put_str(n.script_guid);
+        w.put<uint64_t>(n.text_blocks);
+        w.put<uint64_t>(n.chars);
+        w.put<uint64_t>(n.words);
+        w.put<uint64_t>(n.sentences);
+        w.put<uint64_t>(n.markup_chars);
+        w.put<double>(n.wait_seconds);
+        w.put<uint8_t>(n.is_graph ? 1 : 0);
+        w.put<uint8_t>(n.has_output ? 1 : 0);
+        w.put<uint32_t>(static_cast<uint32_t>(n.texts.size()));
+        for (const auto& t : n.texts) w.put_str(t);
+        w.put<uint32_t>(static_cast<uint32_t>(n.next.size()));
+        for (int64_t id : n.next) w.put<int64_t>(id);
+        w.put<uint32_t>(static_cast<uint32_t>(n.refs.size()));
+        for (const auto& r : n.refs) {
+            w.put_str(r.field);
+            w.put<int64_t>(r.file_id);
+            w.put_str(r.guid);
+        }
+    }
+}
+
+void read_graph(BinaryReader& r, DialogueGraph& graph) {
+    uint32_t count = r.get<uint32_t>();
+    for (uint32_t i = 0; i < count && r.ok; ++i) {
+        DialogueNode n;
+        n.file_id = r.get<int64_t>();
+        n.name = r.get_str();
+        n.script_guid = r.get_str();
+        n.text_blocks = r.get<uint64_t>();
+        n.chars = r.get<uint64_t>();
+        n.words = r.get<uint64_t>();
+        n.sentences = r.get<uint64_t>();
+        n.markup_chars = r.get<uint64_t>();
+        n.wait_seconds = r.get<double>();
+        n.is_graph = r.get<uint8_t>() != 0;
+        n.has_output = r.get<uint8_t>() != 0;
+        uint32_t texts = r.get<uint32_t>();
+        for (uint32_t k = 0; k < texts && r.ok; ++k) n.texts.push_back(r.get_str());
+        uint32_t next = r.get<uint32_t>();
+        for (uint32_t k = 0; k < next && r.ok; ++k) n.next.push_back(r.get<int64_t>());
+        uint32_t refs = r.get<uint32_t>();
+        for (uint32_t k = 0; k < refs && r.ok; ++k) {
+            AssetRef ref;
+            ref.field = r.get_str();
+            ref.file_id = r.get<int64_t>();
+            ref.guid = r.get_str();
+            n.refs.push_back(std::move(ref));
+        }
+        graph.nodes.push_back(std::move(n));
+    }
+}
+
+std::unordered_map<std::string, CacheRecord> load_novel_cache(const std::string& file) {
+    std::unordered_map<std::string, CacheRecord> records;
+    std::string data;
+    if (!read_whole_file(file, data) || data.size() < 16 || memcmp(data.data(), kNovelCacheMagic, 8) != 0) return records;
+    BinaryReader r(data.data() + 8, data.size() - 8);
+    if (r.get<uint32_t>() != kNovelCacheVersion || r.get<uint64_t>() != text_markup.fingerprint()) return records;
+    uint32_t count = r.get<uint32_t>();
+    for (uint32_t i = 0; i < count && r.ok; ++i) {
+        std::string key = r.get_str();
+        CacheRecord rec;
+        rec.size = r.get<uint64_t>();
+        rec.mtime = r.get<int64_t>();
+        rec.hash = r.get<uint64_t>();
+        read_graph(r, rec.graph);
+        if (r.ok) records.emplace(std::move(key), std::move(rec));
+    }
+    if (!r.ok) records.clear();
+    return records;
+}
+
+bool save_novel_cache(const std::string& file, const std::vector<DialogueGraph>& graphs, const std::vector<CacheRecord>& keys) {
+    BinaryWriter w;
+    w.out.append(kNovelCacheMagic, 8);
+    w.put<uint32_t>(kNovelCacheVersion);
+    w.put<uint64_t>(text_markup.fingerprint());
+    w.put<uint32_t>(static_cast<uint32_t>(graphs.size()));
+    for (size_t i = 0; i < graphs.size(); ++i) {
+        w.put_str(graphs[i].path.generic_string());
+        w.put<uint64_t>(keys[i].size);
+        w.put<int64_t>(keys[i].mtime);
+        w.put<uint64_t>(keys[i].hash);
+        write_graph(w, graphs[i]);
+    }
+    std::string tmp = file + ".tmp";
+    bool ok;
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        ok = out.is_open() && out.write(w.out.data(), w.out.size());
+        out.close();
+        ok = ok && !out.fail();
+    }
+    std::error_code ec;
+    if (ok) fs::rename(tmp, file, ec);
+    if (!ok || ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+// Files above twice this size are split at "--- !u!" document boundaries and the
+// chunks are parsed in parallel. No scalar spans a document marker, so every chunk
+// parses exactly as it would in a sequential pass.
+const size_t kChunkBytes = 1 << 20;
+
+// Cleared by --no-chunking, which parses every file in one pass to check the chunked path against.
+bool chunked_parsing = true;
+
+struct ChunkJob {
+    std::string data;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    std::vector<DialogueGraph> parts;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex done_mutex;
+    std::condition_variable all_done;
+
+    // Claims and parses chunks until none are left. Safe to call from any thread.
+    void drain() {
+        for (size_t i = next++; i < ranges.size(); i = next++) {
+            parse_documents(data.data() + ranges[i].first, data.data() + ranges[i].second, parts[i]);
+            if (++done == ranges.size()) {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                all_done.notify_all();
+            }
+        }
+    }
+};
+
+// Splits `data` into document-aligned chunks, lets idle pool workers help with them and
+// merges the per-chunk nodes in file order. The calling worker parses chunks too, so the
+// file finishes even when every other worker is busy.
+void parse_chunked(std::string&& data, DialogueGraph& graph, ThreadPool* pool) {
+    if (!pool || !chunked_parsing || data.size() <= 2 * kChunkBytes) {
+        parse_documents(data.data(), data.data() + data.size(), graph);
+        return;
+    }
+    auto job = std::make_shared<ChunkJob>();
+    job->data = std::move(data);
+    size_t begin = 0;
+    while (begin < job->data.size()) {
+        size_t end = job->data.size();
+        if (begin + kChunkBytes < end) {
+            size_t marker = job->data.find("\n--- !u!", begin + kChunkBytes);
+            if (marker != std::string::npos) end = marker + 1;
+        }
+        job->ranges.push_back({begin, end});
+        begin = end;
+    }
+    job->parts.resize(job->ranges.size());
+    for (size_t i = 1; i < job->ranges.size(); ++i) {
+        pool->enqueue([job]() { job->drain(); });
+    }
+    job->drain();
+    {
+        std::unique_lock<std::mutex> lock(job->done_mutex);
+        job->all_done.wait(lock, [&] { return job->done == job->ranges.size(); });
+    }
+    size_t total = 0;
+    for (const auto& part : job->parts) total += part.nodes.size();
+    graph.nodes.reserve(total);
+    for (auto& part : job->parts) {
+        std::move(part.nodes.begin(), part.nodes.end(), std::back_inserter(graph.nodes));
+    }
+}
+
+// Fills `graph` either from the cache or by parsing, and records the key it was stored under.
+// Returns true when the file had to be parsed.
+bool process_dialogue_file(const fs::path& path, DialogueGraph& graph, CacheRecord& key,
+                           std::unordered_map<std::string, CacheRecord>& cache, ThreadPool* pool) {
+    graph.path = path;
+    std::error_code ec;
+    key.size = fs::file_size(path, ec);
+    auto ft = fs::last_write_time(path, ec);
+    key.mtime = ec ? 0 : static_cast<int64_t>(ft.time_since_epoch().count());
+    auto cached = cache.find(path.generic_string());
+    if (cached != cache.end() && cached->second.size == key.size && cached->second.mtime == key.mtime) {
+        key.hash = cached->second.hash;
+        graph.nodes = std::move(cached->second.graph.nodes);
+        return false;
+    }
+    std::string data;
+    if (!read_whole_file(path, data)) return true;
+    key.hash = content_hash(data);
+    if (cached != cache.end() && cached->second.hash == key.hash && cached->second.size == data.size()) {
+        graph.nodes = std::move(cached->second.graph.nodes);
+        return false;
+    }
+    if (snengine::SerializedFile::detect(data.data(), data.size())) {
+        std::string error;
+        if (!parse_serialized(data, graph, error)) {
+            std::cerr << ("Warning: " + path.string() + ": " + error + "\n");
+        }
+        return true;
+    }
+    parse_chunked(std::move(data), graph, pool);
+    return true;
+}
+
+// The node the engine starts a graph from: its Start node, else the first node in the
+// file. Incoming connections do not matter, since endings often loop back to Start.
+size_t pick_entry(const std::vector<DialogueNode>& nodes) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!nodes[i].is_graph && nodes[i].name.find("Start") != std::string::npos) return i;
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!nodes[i].is_graph) return i;
+    }
+    return SIZE_MAX;
+}
+
+struct GraphIssue {
+    enum Kind { Unreachable, DanglingConnection, DeadEnd } kind;
+    int64_t node;
+    std::string name;
+    int64_t target;
+};
+
+// Port connections of one graph as node indices, shared by validation and route
+// estimates. A graph without any port data runs as a linear script in document order.
+// Connections to fileIDs outside the graph are skipped and reported to `dangling`.
+std::vector<std::vector<uint32_t>> graph_edges(const std::vector<DialogueNode>& nodes, std::vector<GraphIssue>* dangling) {
+    std::unordered_map<int64_t, uint32_t> local;
+    local.reserve(nodes.size());
+    bool has_edges = false;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        local.emplace(nodes[i].file_id, static_cast<uint32_t>(i));
+        has_edges = has_edges || !nodes[i].next.empty();
+    }
+    std::vector<std::vector<uint32_t>> adj(nodes.size());
+    uint32_t prev = UINT32_MAX;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].is_graph) continue;
+        if (!has_edges) {
+            if (prev != UINT32_MAX) adj[prev].push_back(static_cast<uint32_t>(i));
+            prev = static_cast<uint32_t>(i);
+            continue;
+        }
+        for (int64_t target : nodes[i].next) {
+            auto it = local.find(target);
+            if (it != local.end()) {
+                adj[i].push_back(it->second);
+            } else if (dangling) {
+                dangling->push_back({GraphIssue::DanglingConnection, nodes[i].file_id, nodes[i].name, target});
+            }
+        }
+    }
+    return adj;
+}
+
+// Nodes that legitimately end a route: explicitly named end/exit nodes and jumps
+// to another graph's main object.
+bool is_terminal_node(const DialogueNode& node) {
+    for (const char* word : {"End", "Exit", "Finish"}) {
+        if (node.name.find(word) != std::string::npos) return true;
+    }
+    for (const auto& ref : node.refs) {
+        if (ref.file_id == 11400000 && !is_speaker_field(ref.field) && ref.field != "graph") return true;
+    }
+    return false;
+}
+
+// Linear-time checks of one graph: a BFS from the entry node finds unreachable nodes,
+// connections are checked against the graph's own fileIDs, and a node with output ports
+// that leads nowhere and is not a terminal node is a dead end. Edges and the entry are
+// the ones estimate_routes uses.
+std::vector<GraphIssue> validate_graph(const DialogueGraph& graph) {
+    std::vector<GraphIssue> issues;
+    const auto& nodes = graph.nodes;
+    std::vector<std::vector<uint32_t>> adj = graph_edges(nodes, &issues);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        // A node whose only connections are dangling is already reported.
+        if (!nodes[i].is_graph && nodes[i].has_output && adj[i].empty() && nodes[i].next.empty() && !is_terminal_node(nodes[i])) {
+            issues.push_back({GraphIssue::DeadEnd, nodes[i].file_id, nodes[i].name, 0});
+        }
+    }
+
+    size_t start = pick_entry(nodes);
+    std::vector<char> seen(nodes.size(), 0);
+    std::vector<size_t> queue;
+    if (start != SIZE_MAX) {
+        seen[start] = 1;
+        queue.push_back(start);
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        for (size_t v : adj[queue[head]]) {
+            if (!seen[v]) {
+                seen[v] = 1;
+                queue.push_back(v);
+            }
+        }
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!nodes[i].is_graph && !seen[i]) issues.push_back({GraphIssue::Unreachable, nodes[i].file_id, nodes[i].name, 0});
+    }
+    return issues;
+}
+
+// Shortest, longest and expected playthrough over all graphs. Port connections and
+// jumps to other graphs (references to a graph's main object by GUID) form one node graph;
+// edges back to an ancestor are dropped (a loop is read once) and the remaining DAG is
+// solved with a single memoised pass, so the whole thing is O(V + E). Expected length
+// assumes every outgoing branch is picked with equal probability.
+RouteLength estimate_routes(const std::vector<const DialogueGraph*>& graphs) {
+    const int64_t kMainObject = 11400000;
+    std::vector<size_t> offset(graphs.size() + 1, 0);
+    std::unordered_map<std::string, size_t> graph_by_guid;
+    for (size_t g = 0; g < graphs.size(); ++g) {
+        offset[g + 1] = offset[g] + graphs[g]->nodes.size();
+        if (!graphs[g]->guid.empty()) graph_by_guid[graphs[g]->guid] = g;
+    }
+    const size_t n = offset.back();
+    if (n == 0) return {};
+
+    std::vector<std::vector<uint32_t>> adj(n);
+    std::vector<double> cost(n, 0.0);
+    std::vector<uint32_t> entry(graphs.size(), UINT32_MAX);
+    for (size_t g = 0; g < graphs.size(); ++g) {
+        const auto& nodes = graphs[g]->nodes;
+        std::vector<std::vector<uint32_t>> local = graph_edges(nodes, nullptr);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            uint32_t u = static_cast<uint32_t>(offset[g] + i);
+            cost[u] = node_minutes(nodes[i]);
+            for (uint32_t v : local[i]) adj[u].push_back(static_cast<uint32_t>(offset[g] + v));
+        }
+        size_t start = pick_entry(nodes);
+        if (start != SIZE_MAX) entry[g] = static_cast<uint32_t>(offset[g] + start);
+    }
+
+    std::vector<char> is_root(graphs.size(), 1);
+    for (size_t g = 0; g < graphs.size(); ++g) {
+        for (size_t i = 0; i < graphs[g]->nodes.size(); ++i) {
+            for (const auto& ref : graphs[g]->nodes[i].refs) {
+                if (ref.file_id != kMainObject) continue;
+                auto it = graph_by_guid.find(ref.guid);
+                if (it == graph_by_guid.end() || entry[it->second] == UINT32_MAX) continue;
+                adj[offset[g] + i].push_back(entry[it->second]);
+                if (it->second != g) is_root[it->second] = 0;
+            }
+        }
+    }
+
+    // Iterative DFS from the entries; an edge to a node still on the DFS stack jumps back to
+    // an ancestor, so it is dropped and the loop is read once. What remains is a DAG whose
+    // values are filled in post-order.
+    std::vector<RouteLength> best(n);
+    std::vector<char> state(n, 0);
+    std::vector<std::pair<uint32_t, size_t>> call;
+    auto solve = [&](uint32_t s) {
+        if (state[s]) return;
+        state[s] = 1;
+        call.push_back({s, 0});
+        while (!call.empty()) {
+            uint32_t v = call.back().first;
+            size_t& edge = call.back().second;
+            if (edge < adj[v].size()) {
+                uint32_t w = adj[v][edge++];
+                if (!state[w]) {
+                    state[w] = 1;
+                    call.push_back({w, 0});
                 }
-                size_t last_q = full_text.find_last_of(q);
-                if (last_q != std::string::npos) full_text = full_text.substr(0, last_q);
-            } else {
-                full_text = content;
-                std::streampos current_pos = file.tellg();
-                std::string next_line;
-                while (std::getline(file, next_line)) {
-                    if (next_line.empty()) {
-                        current_pos = file.tellg();
-                        continue;
-                    }
-                    size_t next_indent = next_line.find_first_not_of(" ");
-                    if (next_indent != std::string::npos && next_indent <= key_indent) {
-                        file.seekg(current_pos);
-                        break;
-                    }
-                    if (next_line.find("---") != std::string::npos) {
-                        file.seekg(current_pos);
-                        break;
+                continue;
+            }
+            double min_next = 0.0, max_next = 0.0, sum_next = 0.0;
+            size_t exits = 0;
+            for (uint32_t w : adj[v]) {
+                if (state[w] != 2) continue;
+                const RouteLength& r = best[w];
+                min_next = exits ? std::min(min_next, r.shortest) : r.shortest;
+                max_next = std::max(max_next, r.longest);
+                sum_next += r.expected;
+                exits++;
+            }
+            best[v].shortest = cost[v] + min_next;
+            best[v].longest = cost[v] + max_next;
+            best[v].expected = cost[v] + (exits ? sum_next / exits : 0.0);
+            state[v] = 2;
+            call.pop_back();
+        }
+    };
+
+    // Root graphs are alternative starting points, so the totals are the extremes over them.
+    RouteLength total;
+    size_t roots = 0;
+    for (size_t g = 0; g < graphs.size(); ++g) {
+        if (!is_root[g] || entry[g] == UINT32_MAX) continue;
+        solve(entry[g]);
+        const RouteLength& r = best[entry[g]];
+        total.shortest = roots ? std::min(total.shortest, r.shortest) : r.shortest;
+        total.longest = std::max(total.longest, r.longest);
+        total.expected += r.expected;
+        roots++;
+    }
+    if (roots) {
+        total.expected /= roots;
+        return total;
+    }
+    for (size_t g = 0; g < graphs.size(); ++g) {
+        if (entry[g] == UINT32_MAX) continue;
+        solve(entry[g]);
+        return best[entry[g]];
+    }
+    return total;
+}
+
+std::string format_minutes(double minutes) {
+    std::stringstream ss;
+    ss << (int)minutes / 60 << "h " << (int)minutes % 60 << "m";
+    return ss.str();
+}
+
+// Near-duplicate lines: each text gets a 64-bin one-permutation MinHash over 4-code-point
+// shingles of its case-folded words; 8 bands of 8 bins are bucketed (LSH) and only lines
+// sharing a bucket are compared. Lines shorter than kMinDuplicateChars are ignored.
+const size_t kMinHashes = 64;
+const size_t kLshBands = 8;
+const size_t kMinDuplicateChars = 12;
+const double kDuplicateThreshold = 0.8;
+
+struct TextSignature {
+    uint32_t graph;
+    uint32_t node;
+    uint32_t text;
+    std::array<uint32_t, kMinHashes> mins;
+};
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+bool minhash_signature(const std::string& text, std::array<uint32_t, kMinHashes>& mins) {
+    std::string folded = snengine::fold_case(text), norm;
+    snengine::for_each_token(folded, [&](std::string_view t) {
+        if (!norm.empty()) norm += ' ';
+        norm.append(t.data(), t.size());
+    });
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < norm.size(); ++i) {
+        if ((static_cast<unsigned char>(norm[i]) & 0xC0) != 0x80) starts.push_back(i);
+    }
+    if (starts.size() < kMinDuplicateChars) return false;
+    starts.push_back(norm.size());
+    mins.fill(UINT32_MAX);
+    std::array<bool, kMinHashes> filled{};
+    for (size_t i = 0; i + 4 < starts.size(); ++i) {
+        uint64_t h = 1469598103934665603ULL;
+        for (size_t k = starts[i]; k < starts[i + 4]; ++k) h = (h ^ static_cast<unsigned char>(norm[k])) * 1099511628211ULL;
+        h = mix64(h);
+        size_t bin = h >> 58;
+        mins[bin] = std::min(mins[bin], static_cast<uint32_t>(h));
+        filled[bin] = true;
+    }
+    // Rotation densification: an empty bin borrows the next filled bin, offset by the distance.
+    for (size_t b = 0; b < kMinHashes; ++b) {
+        if (filled[b]) continue;
+        for (size_t d = 1; d < kMinHashes; ++d) {
+            size_t src = (b + d) % kMinHashes;
+            if (filled[src]) {
+                mins[b] = mins[src] + static_cast<uint32_t>(d * 0x9E3779B9u);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void graph_signatures(const DialogueGraph& graph, uint32_t graph_index, std::vector<TextSignature>& out) {
+    for (size_t n = 0; n < graph.nodes.size(); ++n) {
+        const auto& texts = graph.nodes[n].texts;
+        for (size_t t = 0; t < texts.size(); ++t) {
+            TextSignature sig;
+            sig.graph = graph_index;
+            sig.node = static_cast<uint32_t>(n);
+            sig.text = static_cast<uint32_t>(t);
+            if (minhash_signature(texts[t], sig.mins)) out.push_back(sig);
+        }
+    }
+}
+
+struct TextRef {
+    uint32_t graph;
+    uint32_t node;
+    uint32_t text;
+};
+
+// Clusters of near-duplicate lines, largest first. Each LSH bucket is compared against
+// its first member only, so the work stays linear in the number of signatures.
+std::vector<std::vector<TextRef>> find_near_duplicates(const std::vector<TextSignature>& sigs) {
+    std::vector<uint32_t> parent(sigs.size());
+    for (uint32_t i = 0; i < parent.size(); ++i) parent[i] = i;
+    auto find = [&](uint32_t x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    auto similarity = [&](const TextSignature& a, const TextSignature& b) {
+        size_t same = 0;
+        for (size_t k = 0; k < kMinHashes; ++k) same += a.mins[k] == b.mins[k];
+        return static_cast<double>(same) / kMinHashes;
+    };
+    const size_t rows = kMinHashes / kLshBands;
+    std::vector<std::pair<uint64_t, uint32_t>> buckets(sigs.size());
+    for (size_t band = 0; band < kLshBands; ++band) {
+        for (uint32_t i = 0; i < sigs.size(); ++i) {
+            uint64_t h = band;
+            for (size_t r = 0; r < rows; ++r) h = mix64(h ^ sigs[i].mins[band * rows + r]);
+            buckets[i] = {h, i};
+        }
+        std::sort(buckets.begin(), buckets.end());
+        for (size_t start = 0, end; start < buckets.size(); start = end) {
+            end = start + 1;
+            while (end < buckets.size() && buckets[end].first == buckets[start].first) end++;
+            const uint32_t first = buckets[start].second;
+            for (size_t k = start + 1; k < end; ++k) {
+                uint32_t other = buckets[k].second;
+                if (find(first) != find(other) && similarity(sigs[first], sigs[other]) >= kDuplicateThreshold) {
+                    parent[find(other)] = find(first);
+                }
+            }
+        }
+    }
+    std::unordered_map<uint32_t, std::vector<TextRef>> groups;
+    for (uint32_t i = 0; i < sigs.size(); ++i) {
+        uint32_t root = find(i);
+        groups[root].push_back({sigs[i].graph, sigs[i].node, sigs[i].text});
+    }
+    std::vector<std::vector<TextRef>> clusters;
+    for (auto& kv : groups) {
+        if (kv.second.size() > 1) clusters.push_back(std::move(kv.second));
+    }
+    std::sort(clusters.begin(), clusters.end(), [](const auto& a, const auto& b) {
+        if (a.size() != b.size()) return a.size() > b.size();
+        return std::tie(a[0].graph, a[0].node, a[0].text) < std::tie(b[0].graph, b[0].node, b[0].text);
+    });
+    return clusters;
+}
+
+// Open-addressed table over the distinct m_Script GUIDs of a project (a few dozen at
+// most). The seed and size are searched until every key owns its slot, so a lookup
+// is one hash and one compare. Keys whose 64-bit hashes collide can never be separated
+// by the seed, so the search is bounded and falls back to a hash map.
+class ScriptTable {
+public:
+    explicit ScriptTable(const std::vector<std::string>& keys) : keys_(keys) {
+        size_t size = 1;
+        while (size < keys.size() * 2) size <<= 1;
+        for (const size_t last = size << 4; size <= last; size <<= 1) {
+            for (seed_ = 0; seed_ < 64; ++seed_) {
+                slots_.assign(size, SIZE_MAX);
+                mask_ = size - 1;
+                bool ok = true;
+                for (size_t i = 0; i < keys.size() && ok; ++i) {
+                    size_t& slot = slots_[slot_of(keys[i])];
+                    ok = slot == SIZE_MAX;
+                    slot = i;
+                }
+                if (ok) return;
+            }
+        }
+        slots_.clear();
+        fallback_.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) fallback_.emplace(keys[i], i);
+    }
+
+    // Index into the constructor's key list, or SIZE_MAX.
+    size_t find(const std::string& key) const {
+        if (slots_.empty()) {
+            auto it = fallback_.find(key);
+            return it != fallback_.end() ? it->second : SIZE_MAX;
+        }
+        size_t i = slots_[slot_of(key)];
+        return i != SIZE_MAX && keys_[i] == key ? i : SIZE_MAX;
+    }
+
+private:
+    size_t slot_of(const std::string& key) const { return static_cast<size_t>(mix64(content_hash(key) ^ seed_)) & mask_; }
+
+    const std::vector<std::string>& keys_;
+    std::vector<size_t> slots_;
+    std::unordered_map<std::string, size_t> fallback_;
+    uint64_t seed_ = 0;
+    size_t mask_ = 0;
+};
+
+struct NodeType {
+    std::string guid;
+    std::string path;
+    std::string script;
+    std::string category;
+    size_t count = 0;
+};
+
+// Coarse node kind from the script name, for QA estimates; first match wins.
+std::string node_category(const std::string& script, bool is_graph) {
+    static const std::pair<const char*, std::vector<const char*>> kCategories[] = {
+        {"choice", {"Choice", "Select", "Branch", "Option"}},
+        {"jump", {"Jump", "Goto", "Transition"}},
+        {"wait", {"Wait", "Delay"}},
+        {"character", {"Character", "Show", "Hide", "Emotion"}},
+        {"dialogue", {"Dialog", "Say", "Message", "Text"}},
+    };
+    if (is_graph) return "graph";
+    for (const auto& c : kCategories) {
+        for (const char* word : c.second) {
+            if (script.find(word) != std::string::npos) return c.first;
+        }
+    }
+    return "custom";
+}
+
+// Histogram of node scripts over `graphs`, resolved to script names through the GUID
+// index. `per_graph` receives one count vector per graph, indexed like the result.
+std::vector<NodeType> node_type_histogram(const std::vector<const DialogueGraph*>& graphs, const snengine::GuidIndex& guids,
+                                          std::vector<std::vector<size_t>>& per_graph) {
+    std::vector<std::string> keys;
+    std::unordered_set<std::string> seen;
+    std::vector<char> graph_script;
+    for (const DialogueGraph* g : graphs) {
+        for (const auto& n : g->nodes) {
+            if (!seen.insert(n.script_guid).second) continue;
+            keys.push_back(n.script_guid);
+            graph_script.push_back(n.is_graph);
+        }
+    }
+    ScriptTable table(keys);
+    std::vector<NodeType> types(keys.size());
+    per_graph.assign(graphs.size(), std::vector<size_t>(keys.size(), 0));
+    for (size_t g = 0; g < graphs.size(); ++g) {
+        for (const auto& n : graphs[g]->nodes) per_graph[g][table.find(n.script_guid)]++;
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+        NodeType& t = types[i];
+        t.guid = keys[i];
+        const snengine::GuidEntry* e = keys[i].empty() ? nullptr : guids.find(keys[i]);
+        t.script = e ? fs::path(std::string(guids.path(*e))).stem().string() : (keys[i].empty() ? "(no script)" : keys[i]);
+        t.path = e ? std::string(guids.path(*e)) : t.script;
+        t.category = node_category(e ? t.script : "", graph_script[i]);
+        for (const auto& counts : per_graph) t.count += counts[i];
+    }
+    return types;
+}
+
+class BlobStrings {
+public:
+    // Empty optional fields (name, speaker, ...) are stored as kBlobNone; pass
+    // `keep_empty` for dialogue text, where an empty line is still a line.
+    uint32_t id(const std::string& s, bool keep_empty = false) {
+        if (s.empty() && !keep_empty) return snengine::kBlobNone;
+        auto it = ids.find(s);
+        if (it != ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(list.size());
+        ids.emplace(s, id);
+        list.push_back(s);
+        return id;
+    }
+    std::vector<std::string> list;
+private:
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+std::string speaker_name(const DialogueNode& node, const CharacterIndex& characters) {
+    for (const auto& ref : node.refs) {
+        if (!is_speaker_field(ref.field)) continue;
+        auto it = characters.by_ref.find(ref_key(ref.guid, ref.file_id));
+        return it != characters.by_ref.end() ? characters.names[it->second] : ref_key(ref.guid, ref.file_id);
+    }
+    return "";
+}
+
+// Writes every graph as a dialogue_blob.hpp image. Connections to missing nodes are
+// dropped; jumps to other exported graphs are stored as graph indices.
+bool export_blob(const std::string& file, const std::vector<DialogueGraph>& graphs, const fs::path& root,
+                 const CharacterIndex& characters) {
+    using namespace snengine;
+    BlobStrings strings;
+    std::vector<BlobGraph> graph_table;
+    std::vector<BlobNode> node_table;
+    std::vector<uint32_t> edges, texts;
+    std::unordered_map<std::string, uint32_t> graph_by_guid;
+    for (size_t g = 0; g < graphs.size(); ++g) {
+        if (!graphs[g].guid.empty()) graph_by_guid.emplace(graphs[g].guid, static_cast<uint32_t>(g));
+    }
+    for (size_t g = 0; g < graphs.size(); ++g) {
+        const auto& nodes = graphs[g].nodes;
+        const uint32_t first = static_cast<uint32_t>(node_table.size());
+        std::unordered_map<int64_t, uint32_t> local;
+        for (size_t i = 0; i < nodes.size(); ++i) local.emplace(nodes[i].file_id, static_cast<uint32_t>(i));
+        for (const auto& n : nodes) {
+            BlobNode b{};
+            b.file_id = n.file_id;
+            b.wait_seconds = n.wait_seconds;
+            b.name = strings.id(n.name);
+            b.script = strings.id(n.script_guid);
+            b.speaker = strings.id(speaker_name(n, characters));
+            b.jump_graph = kBlobNone;
+            for (const auto& ref : n.refs) {
+                auto it = graph_by_guid.find(ref.guid);
+                if (ref.file_id == 11400000 && it != graph_by_guid.end() && !is_speaker_field(ref.field)) {
+                    b.jump_graph = it->second;
+                    break;
+                }
+            }
+            b.first_text = static_cast<uint32_t>(texts.size());
+            for (const auto& t : n.texts) texts.push_back(strings.id(t, true));
+            b.text_count = static_cast<uint32_t>(n.texts.size());
+            b.first_edge = static_cast<uint32_t>(edges.size());
+            for (int64_t target : n.next) {
+                auto it = local.find(target);
+                if (it == local.end()) continue;
+                edges.push_back(first + it->second);
+            }
+            b.edge_count = static_cast<uint32_t>(edges.size()) - b.first_edge;
+            node_table.push_back(b);
+        }
+        size_t entry = pick_entry(nodes);
+        graph_table.push_back({strings.id(graphs[g].path.lexically_relative(root).generic_string()), strings.id(graphs[g].guid),
+                               first, static_cast<uint32_t>(nodes.size()),
+                               entry == SIZE_MAX ? kBlobNone : first + static_cast<uint32_t>(entry), 0});
+    }
+    std::vector<BlobString> string_table;
+    std::string string_data;
+    for (const auto& str : strings.list) {
+        string_table.push_back({static_cast<uint32_t>(string_data.size()), static_cast<uint32_t>(str.size())});
+        string_data += str;
+    }
+    auto align = [](uint64_t v) { return (v + 7) & ~uint64_t(7); };
+    BlobHeader h{};
+    memcpy(h.magic, "SNDLGBIN", 8);
+    h.version = DialogueBlob::kVersion;
+    h.byte_order = kBlobByteOrder;
+    h.graph_count = static_cast<uint32_t>(graph_table.size());
+    h.node_count = static_cast<uint32_t>(node_table.size());
+    h.edge_count = static_cast<uint32_t>(edges.size());
+    h.text_count = static_cast<uint32_t>(texts.size());
+    h.string_count = static_cast<uint32_t>(string_table.size());
+    h.graphs_offset = sizeof(BlobHeader);
+    h.nodes_offset = align(h.graphs_offset + graph_table.size() * sizeof(BlobGraph));
+    h.edges_offset = align(h.nodes_offset + node_table.size() * sizeof(BlobNode));
+    h.texts_offset = align(h.edges_offset + edges.size() * 4);
+    h.strings_offset = align(h.texts_offset + texts.size() * 4);
+    h.string_data_offset = align(h.strings_offset + string_table.size() * sizeof(BlobString));
+    h.total_size = h.string_data_offset + string_data.size();
+
+    std::string image;
+    image.reserve(h.total_size);
+    auto put = [&](uint64_t offset, const void* data, size_t bytes) {
+        image.resize(offset, '\0');
+        image.append(static_cast<const char*>(data), bytes);
+    };
+    put(0, &h, sizeof(h));
+    put(h.graphs_offset, graph_table.data(), graph_table.size() * sizeof(BlobGraph));
+    put(h.nodes_offset, node_table.data(), node_table.size() * sizeof(BlobNode));
+    put(h.edges_offset, edges.data(), edges.size() * 4);
+    put(h.texts_offset, texts.data(), texts.size() * 4);
+    put(h.strings_offset, string_table.data(), string_table.size() * sizeof(BlobString));
+    put(h.string_data_offset, string_data.data(), string_data.size());
+    h.checksum = image_checksum(image.data() + sizeof(h), image.size() - sizeof(h));
+    memcpy(&image[0], &h, sizeof(h));
+
+    std::string tmp = file + ".tmp";
+    std::ofstream out(tmp, std::ios::binary);
+    bool ok = out.is_open() && out.write(image.data(), image.size()).good();
+    out.close();
+    std::error_code ec;
+    if (ok) fs::rename(tmp, file, ec);
+    if (!ok || ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+// Reopens an exported blob through the reader API and compares it with the parsed graphs.
+bool verify_blob(const std::string& file, const std::vector<DialogueGraph>& graphs, std::string& error) {
+    snengine::DialogueBlob blob;
+    if (!blob.open(file)) { error = "blob failed validation"; return false; }
+    if (blob.graph_count() != graphs.size()) { error = "graph count differs"; return false; }
+    for (uint32_t g = 0; g < blob.graph_count(); ++g) {
+        const snengine::BlobGraph& bg = blob.graph(g);
+        const auto& nodes = graphs[g].nodes;
+        if (bg.node_count != nodes.size() || blob.string(bg.guid) != graphs[g].guid) {
+            error = graphs[g].path.string() + ": graph header differs";
+            return false;
+        }
+        std::unordered_set<int64_t> ids;
+        for (const auto& n : nodes) ids.insert(n.file_id);
+        for (uint32_t i = 0; i < bg.node_count; ++i) {
+            const snengine::BlobNode& bn = blob.node(bg.first_node + i);
+            const DialogueNode& n = nodes[i];
+            bool same = bn.file_id == n.file_id && bn.wait_seconds == n.wait_seconds && blob.string(bn.name) == n.name &&
+                        blob.string(bn.script) == n.script_guid && bn.text_count == n.texts.size();
+            for (uint32_t k = 0; same && k < bn.text_count; ++k) same = blob.text(bn, k) == n.texts[k];
+            uint32_t k = 0;
+            for (int64_t target : n.next) {
+                if (!same || !ids.count(target)) continue;
+                same = k < bn.edge_count && blob.node(blob.edge(bn, k++)).file_id == target;
+            }
+            if (!same || k != bn.edge_count) {
+                error = graphs[g].path.string() + ": node #" + std::to_string(n.file_id) + " differs";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Folder names such as "en", "ru", "pt-BR", "zh_Hans": an ISO 639-1 language (or one of
+// the few three-letter codes Unity ships) with an optional region or script.
+bool is_locale_code(const std::string& name) {
+    static const char* const kLanguages[] = {
+        "aa", "ab", "ae", "af", "ak", "am", "an", "ar", "as", "ast", "av", "ay", "az", "ba", "be", "bg", "bh", "bi",
+        "bm", "bn", "bo", "br", "bs", "ca", "ce", "ceb", "ch", "co", "cr", "cs", "cu", "cv", "cy", "da", "de", "dv",
+        "dz", "ee", "el", "en", "eo", "es", "et", "eu", "fa", "ff", "fi", "fil", "fj", "fo", "fr", "fy", "ga", "gd",
+        "gl", "gn", "gu", "gv", "ha", "haw", "he", "hi", "ho", "hr", "ht", "hu", "hy", "hz", "ia", "id", "ie", "ig",
+        "ii", "ik", "io", "is", "it", "iu", "ja", "jv", "ka", "kg", "ki", "kj", "kk", "kl", "km", "kn", "ko", "kr",
+        "ks", "ku", "kv", "kw", "ky", "la", "lb", "lg", "li", "ln", "lo", "lt", "lu", "lv", "mg", "mh", "mi", "mk",
+        "ml", "mn", "mr", "ms", "mt", "my", "na", "nb", "nd", "ne", "ng", "nl", "nn", "no", "nr", "nv", "ny", "oc",
+        "oj", "om", "or", "os", "pa", "pi", "pl", "ps", "pt", "qu", "rm", "rn", "ro", "ru", "rw", "sa", "sc", "sd",
+        "se", "sg", "si", "sk", "sl", "sm", "sn", "so", "sq", "sr", "ss", "st", "su", "sv", "sw", "ta", "te", "tg",
+        "th", "ti", "tk", "tl", "tn", "to", "tr", "ts", "tt", "tw", "ty", "ug", "uk", "ur", "uz", "ve", "vi", "vo",
+        "wa", "wo", "xh", "yi", "yo", "yue", "za", "zh", "zu"};
+    size_t i = 0;
+    while (i < name.size() && name[i] >= 'a' && name[i] <= 'z') i++;
+    if (i < 2 || i > 3) return false;
+    std::string language = name.substr(0, i);
+    if (!std::binary_search(std::begin(kLanguages), std::end(kLanguages), language,
+                            [](const std::string& a, const std::string& b) { return a < b; })) {
+        return false;
+    }
+    if (i == name.size()) return true;
+    if (name[i] != '-' && name[i] != '_') return false;
+    size_t rest = name.size() - i - 1;
+    if (rest < 2 || rest > 4) return false;
+    for (size_t k = i + 1; k < name.size(); ++k) {
+        if (!std::isalnum(static_cast<unsigned char>(name[k]))) return false;
+    }
+    return true;
+}
+
+// Unity Localization StringTable: one asset per locale, entries keyed by m_Id within
+// the collection identified by the m_SharedData GUID.
+struct StringTable {
+    std::string locale;
+    std::string shared_guid;
+    std::vector<int64_t> ids;
+    size_t chars = 0;
+    size_t words = 0;
+    size_t sentences = 0;
+};
+
+void parse_string_table(const fs::path& path, StringTable& table) {
+    std::string data;
+    if (!read_whole_file(path, data) || data.find("m_TableData:") == std::string::npos) return;
+    LineCursor cursor(data.data(), data.data() + data.size());
+    std::string_view line;
+    int64_t current_id = 0;
+    while (cursor.next(line)) {
+        std::string_view body = trim_left(line);
+        if (body.compare(0, 8, "m_Code: ") == 0 && table.locale.empty()) {
+            table.locale = std::string(body.substr(8));
+        } else if (body.compare(0, 13, "m_SharedData:") == 0) {
+            table.shared_guid = parse_guid(body);
+        } else if (body.compare(0, 8, "- m_Id: ") == 0) {
+            current_id = std::strtoll(std::string(body.substr(8)).c_str(), nullptr, 10);
+        } else if (body.compare(0, 13, "m_Localized: ") == 0) {
+            TextMetrics m;
+            if (measure_text(read_text_value(line, line.find("m_Localized: ") + 13, cursor), m)) {
+                table.ids.push_back(current_id);
+                table.chars += m.chars;
+                table.words += m.words;
+                table.sentences += m.sentences;
+            }
+        }
+    }
+}
+
+struct LocaleReport {
+    std::string code;
+    size_t graphs = 0;
+    size_t table_entries = 0;
+    size_t text_blocks = 0;
+    size_t chars = 0;
+    size_t words = 0;
+    size_t sentences = 0;
+    double playtime_minutes = 0.0;
+    double coverage = 0.0;
+};
+
+// Coverage of a locale is the share of base-locale text (graph nodes matched by
+// relative path and fileID, table entries by collection and id) that also has text in it.
+// When the base locale has no string tables, the largest table locale stands in for it.
+std::vector<LocaleReport> build_locale_reports(const std::vector<DialogueGraph>& graphs,
+                                               const std::vector<std::string>& graph_locale,
+                                               const std::vector<std::string>& graph_rel,
+                                               const std::vector<StringTable>& tables,
+                                               std::string& base_code) {
+    std::map<std::string, LocaleReport> by_code;
+    for (size_t i = 0; i < graphs.size(); ++i) {
+        LocaleReport& r = by_code[graph_locale[i]];
+        r.graphs++;
+        for (const auto& n : graphs[i].nodes) {
+            r.text_blocks += n.text_blocks;
+            r.chars += n.chars;
+            r.words += n.words;
+            r.sentences += n.sentences;
+        }
+    }
+    for (const auto& t : tables) {
+        if (t.locale.empty()) continue;
+        LocaleReport& r = by_code[t.locale];
+        r.table_entries += t.ids.size();
+        r.text_blocks += t.ids.size();
+        r.chars += t.chars;
+        r.words += t.words;
+        r.sentences += t.sentences;
+    }
+    if (by_code.empty()) return {};
+    if (!by_code.count(base_code)) {
+        base_code = by_code.count("default") && by_code["default"].graphs ? "default" : "";
+        if (base_code.empty()) {
+            for (const auto& kv : by_code) {
+                if (base_code.empty() || kv.second.text_blocks > by_code[base_code].text_blocks) base_code = kv.first;
+            }
+        }
+    }
+
+    std::map<std::string, std::unordered_map<std::string, size_t>> graph_by_rel;
+    for (size_t i = 0; i < graphs.size(); ++i) graph_by_rel[graph_locale[i]][graph_rel[i]] = i;
+    std::string table_base = base_code;
+    std::map<std::string, std::unordered_set<std::string>> table_keys;
+    for (const auto& t : tables) {
+        for (int64_t id : t.ids) table_keys[t.locale].insert(t.shared_guid + ":" + std::to_string(id));
+    }
+    if (!table_keys.count(table_base)) {
+        table_base.clear();
+        for (const auto& kv : table_keys) {
+            if (table_base.empty() || kv.second.size() > table_keys[table_base].size()) table_base = kv.first;
+        }
+    }
+
+    std::vector<LocaleReport> reports;
+    for (auto& kv : by_code) {
+        LocaleReport& r = kv.second;
+        r.code = kv.first;
+        std::vector<const DialogueGraph*> own;
+        for (size_t i = 0; i < graphs.size(); ++i) {
+            if (graph_locale[i] == r.code) own.push_back(&graphs[i]);
+        }
+        size_t table_chars = 0;
+        for (const auto& t : tables) {
+            if (t.locale == r.code) table_chars += t.chars;
+        }
+        r.playtime_minutes = estimate_routes(own).expected + table_chars / 800.0 * 1.2;
+
+        size_t reference = 0, translated = 0;
+        auto base_graphs = graph_by_rel.find(base_code);
+        auto own_graphs = graph_by_rel.find(r.code);
+        if (base_graphs != graph_by_rel.end()) {
+            for (const auto& g : base_graphs->second) {
+                const DialogueGraph* counterpart = nullptr;
+                if (own_graphs != graph_by_rel.end()) {
+                    auto it = own_graphs->second.find(g.first);
+                    if (it != own_graphs->second.end()) counterpart = &graphs[it->second];
+                }
+                std::unordered_set<int64_t> with_text;
+                if (counterpart) {
+                    for (const auto& n : counterpart->nodes) {
+                        if (n.text_blocks) with_text.insert(n.file_id);
                     }
-                    full_text += " " + next_line;
-                    current_pos = file.tellg();
+                }
+                for (const auto& n : graphs[g.second].nodes) {
+                    if (!n.text_blocks) continue;
+                    reference++;
+                    if (with_text.count(n.file_id)) translated++;
                 }
             }
-            process_text_content(full_text, stats);
         }
+        if (!table_base.empty()) {
+            const auto& base_keys = table_keys[table_base];
+            reference += base_keys.size();
+            auto own_keys = table_keys.find(r.code == base_code ? table_base : r.code);
+            if (own_keys != table_keys.end()) {
+                for (const auto& k : base_keys) translated += own_keys->second.count(k);
+            }
+        }
+        r.coverage = reference ? static_cast<double>(translated) / reference : (r.code == base_code ? 1.0 : 0.0);
+        reports.push_back(r);
+    }
+    std::stable_partition(reports.begin(), reports.end(), [&](const LocaleReport& r) { return r.code == base_code; });
+    return reports;
+}
+
+// Directories Unity never imports (trailing '~', leading '.') and per-machine caches
+// that can dwarf the project itself.
+bool is_pruned_dir(const std::string& name) {
+    static const char* const kPruned[] = {"Library", "Temp", "Logs", "obj", "Build", "Builds", "UserSettings", "node_modules"};
+    if (name.empty() || name[0] == '.' || name.back() == '~') return true;
+    for (const char* p : kPruned) {
+        if (name == p) return true;
     }
+    return false;
+}
+
+struct ProjectLayout {
+    std::vector<fs::path> dialogue_roots;
+    std::vector<fs::path> character_roots;
+    std::vector<fs::path> localisation_roots;
+    std::vector<std::pair<fs::path, size_t>> dialogue_assets;
+    std::vector<fs::path> character_assets;
+    std::vector<fs::path> table_assets;
+    // .meta files of the walked tree as '/'-separated paths relative to the project root.
+    std::vector<std::string> meta_files;
+};
+
+// Breadth-first scan of Assets/ (or the root when there is none) that finds every
+// Dialogues, Characters and Localization folder and lists their .asset files in the same
+// pass. Explicitly given folders replace auto-detection for their kind. The .meta files
+// seen on the way are collected for the GUID index, so the project is walked only once.
+// The engine's own Assets/SNEngine/Demo tree is only searched with `include_demo`, and a
+// Characters folder never holds dialogues, even inside a Dialogues folder.
+ProjectLayout scan_project(const fs::path& root, const std::vector<fs::path>& dialogues, const std::vector<fs::path>& characters,
+                           bool include_demo) {
+    struct Pending {
+        fs::path dir;
+        int dialogue_root;
+        bool characters;
+        bool localisation;
+        bool metas;
+        std::string rel;
+        bool demo;
+    };
+    ProjectLayout layout;
+    std::deque<Pending> queue;
+    std::set<std::string> explicit_dirs;
+    std::error_code ec;
+    fs::path assets = root / "Assets";
+    const bool has_assets = fs::is_directory(assets, ec);
+    const fs::path scan_root = fs::absolute(has_assets ? assets : root, ec).lexically_normal();
+    // An explicit folder inside the walked tree is skipped by the walk, so it lists its own .meta files.
+    auto explicit_dir = [&](const fs::path& dir, int dialogue_root, bool chars) {
+        fs::path rel = fs::absolute(dir, ec).lexically_normal().lexically_relative(scan_root);
+        bool inside = !rel.empty() && rel != "." && *rel.begin() != "..";
+        std::string base = has_assets ? "Assets" : "";
+        std::string r = rel.generic_string();
+        queue.push_back({dir, dialogue_root, chars, false, inside, base.empty() ? r : base + "/" + r, false});
+        explicit_dirs.insert(dir.lexically_normal().generic_string());
+    };
+    for (const auto& d : dialogues) {
+        layout.dialogue_roots.push_back(d);
+        explicit_dir(d, static_cast<int>(layout.dialogue_roots.size() - 1), false);
+    }
+    for (const auto& c : characters) {
+        layout.character_roots.push_back(c);
+        explicit_dir(c, -1, true);
+    }
+    queue.push_back({has_assets ? assets : root, -1, false, false, true, has_assets ? "Assets" : "", false});
+    const size_t explicit_count = queue.size() - 1;
+
+    for (size_t processed = 0; !queue.empty(); ++processed) {
+        Pending cur = std::move(queue.front());
+        queue.pop_front();
+        bool auto_scan = processed >= explicit_count && !cur.demo;
+        for (fs::directory_iterator it(cur.dir, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec)) {
+            const fs::directory_entry& entry = *it;
+            std::string name = entry.path().filename().string();
+            std::error_code sec;
+            if (entry.is_directory(sec) && !entry.is_symlink(sec)) {
+                if (is_pruned_dir(name)) continue;
+                if (explicit_dirs.count(entry.path().lexically_normal().generic_string())) continue;
+                Pending child{entry.path(), cur.dialogue_root, cur.characters, cur.localisation, cur.metas,
+                              cur.rel.empty() ? name : cur.rel + "/" + name, cur.demo};
+                // Still walked for its .meta files, which project assets may reference.
+                if (!include_demo && name == "Demo" && cur.dir.filename() == "SNEngine") child.demo = true;
+                if (name == "Characters") child.dialogue_root = -1;
+                if (auto_scan && dialogues.empty() && name == "Dialogues" && child.dialogue_root < 0) {
+                    layout.dialogue_roots.push_back(entry.path());
+                    child.dialogue_root = static_cast<int>(layout.dialogue_roots.size() - 1);
+                }
+                if (auto_scan && characters.empty() && name == "Characters" && !child.characters) {
+                    layout.character_roots.push_back(entry.path());
+                    child.characters = true;
+                }
+                if (auto_scan && (name == "Localization" || name == "Localisation") && !child.localisation) {
+                    layout.localisation_roots.push_back(entry.path());
+                    child.localisation = true;
+                }
+                queue.push_back(std::move(child));
+            } else if (cur.metas && entry.path().extension() == ".meta") {
+                layout.meta_files.push_back(cur.rel.empty() ? name : cur.rel + "/" + name);
+            } else if (entry.path().extension() == ".asset") {
+                if (cur.dialogue_root >= 0) layout.dialogue_assets.push_back({entry.path(), static_cast<size_t>(cur.dialogue_root)});
+                else if (cur.characters) layout.character_assets.push_back(entry.path());
+                else if (cur.localisation) layout.table_assets.push_back(entry.path());
+            }
+        }
+        ec.clear();
+    }
+    return layout;
+}
+
+// A first-level folder of a Dialogues root holds a locale only when its name is a
+// language code and a sibling locale folder (or the root itself) has an asset at the
+// same relative path, so story folders that happen to look like codes ("ch", "ms")
+// stay part of the base text. Returns (root index, folder name) pairs.
+std::set<std::pair<size_t, std::string>> find_locale_folders(const ProjectLayout& layout) {
+    std::map<std::pair<size_t, std::string>, std::set<std::string>> candidates;
+    for (const auto& a : layout.dialogue_assets) {
+        fs::path rel = a.first.lexically_relative(layout.dialogue_roots[a.second]);
+        std::string first = rel.begin()->string();
+        if (!rel.has_parent_path()) {
+            candidates[{a.second, ""}].insert(rel.generic_string());
+        } else if (is_locale_code(first)) {
+            candidates[{a.second, first}].insert(rel.lexically_relative(first).generic_string());
+        }
+    }
+    std::set<std::pair<size_t, std::string>> locales;
+    for (const auto& c : candidates) {
+        if (c.first.second.empty()) continue;
+        for (const auto& other : candidates) {
+            if (other.first.first != c.first.first || other.first == c.first) continue;
+            bool parallel = std::any_of(c.second.begin(), c.second.end(),
+                                        [&](const std::string& rel) { return other.second.count(rel) > 0; });
+            if (parallel) {
+                locales.insert(c.first);
+                break;
+            }
+        }
+    }
+    return locales;
+}
+
+// A query wrapped in double quotes is matched as a phrase; otherwise every word must occur.
+int run_query(const snengine::TextIndex& index, const std::string& query) {
+    auto started = std::chrono::steady_clock::now();
+    bool phrase = query.size() >= 2 && query.front() == '"' && query.back() == '"';
+    std::vector<uint32_t> hits = index.search(phrase ? query.substr(1, query.size() - 2) : query, phrase);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    for (uint32_t d : hits) {
+        const auto& doc = index.doc(d);
+        std::cout << index.graph_path(doc) << " #" << doc.file_id << ": " << index.text(doc) << std::endl;
+    }
+    std::cout << hits.size() << " match(es) in " << std::fixed << std::setprecision(2) << ms << " ms" << std::endl;
+    return 0;
+}
+
+struct TextChange {
+    enum Kind { Added, Removed, Modified } kind;
+    std::string graph;
+    int64_t node;
+    std::string old_text;
+    std::string new_text;
+};
+
+// Line-level changes of one graph. Nodes are matched by fileID (stable across edits in
+// Unity YAML) and text blocks by position inside the node.
+void diff_graph(const std::string& rel, const DialogueGraph* before, const DialogueGraph* after, std::vector<TextChange>& out) {
+    static const DialogueGraph kEmpty;
+    if (!before) before = &kEmpty;
+    if (!after) after = &kEmpty;
+    std::unordered_map<int64_t, const DialogueNode*> old_nodes;
+    for (const auto& n : before->nodes) old_nodes.emplace(n.file_id, &n);
+    for (const auto& n : after->nodes) {
+        auto it = old_nodes.find(n.file_id);
+        const DialogueNode* o = it != old_nodes.end() ? it->second : nullptr;
+        const size_t old_count = o ? o->texts.size() : 0;
+        for (size_t k = 0; k < n.texts.size(); ++k) {
+            if (k >= old_count) {
+                out.push_back({TextChange::Added, rel, n.file_id, "", n.texts[k]});
+            } else if (o->texts[k] != n.texts[k]) {
+                out.push_back({TextChange::Modified, rel, n.file_id, o->texts[k], n.texts[k]});
+            }
+        }
+        for (size_t k = n.texts.size(); k < old_count; ++k) out.push_back({TextChange::Removed, rel, n.file_id, o->texts[k], ""});
+        if (o) old_nodes.erase(it);
+    }
+    for (const auto& n : before->nodes) {
+        if (!old_nodes.count(n.file_id)) continue;
+        for (const auto& t : n.texts) out.push_back({TextChange::Removed, rel, n.file_id, t, ""});
+    }
+}
+
+// True when both graphs hold the same nodes with the same texts, in the same order.
+bool same_text(const DialogueGraph& a, const DialogueGraph& b) {
+    if (a.nodes.size() != b.nodes.size()) return false;
+    for (size_t i = 0; i < a.nodes.size(); ++i) {
+        if (a.nodes[i].file_id != b.nodes[i].file_id || a.nodes[i].texts != b.nodes[i].texts) return false;
+    }
+    return true;
+}
+
+// Compares the dialogue text of two project checkouts. Both trees are parsed on one pool
+// (through each root's analysis cache when present) with the same discovery options;
+// given folders inside the new root are looked up at the same relative path in the old
+// one. Graphs are paired by their path relative to the project root and skipped when
+// their file hashes match and their texts are equal.
+int run_diff(const fs::path& old_root, const fs::path& new_root, const std::string& json_out,
+             const std::vector<fs::path>& dialogues, const std::vector<fs::path>& characters, bool include_demo) {
+    const fs::path roots[2] = {old_root, new_root};
+    auto on_old_side = [&](std::vector<fs::path> dirs) {
+        for (auto& d : dirs) {
+            fs::path rel = d.lexically_relative(new_root);
+            if (!rel.empty() && *rel.begin() != "..") d = (old_root / rel).lexically_normal();
+        }
+        return dirs;
+    };
+    const std::vector<fs::path> dialogue_dirs[2] = {on_old_side(dialogues), dialogues};
+    const std::vector<fs::path> character_dirs[2] = {on_old_side(characters), characters};
+    std::vector<fs::path> assets[2];
+    std::unordered_map<std::string, CacheRecord> caches[2];
+    for (int side = 0; side < 2; ++side) {
+        ProjectLayout layout = scan_project(roots[side], dialogue_dirs[side], character_dirs[side], include_demo);
+        if (layout.dialogue_roots.empty()) {
+            std::cerr << "Error: No Dialogues folder in " << roots[side].string() << "!" << std::endl;
+            return 1;
+        }
+        for (const auto& a : layout.dialogue_assets) assets[side].push_back(a.first);
+        fs::path cache_file = roots[side] / "Library" / "SNEngineNovelCache.bin";
+        if (fs::exists(cache_file)) caches[side] = load_novel_cache(cache_file.string());
+    }
+
+    std::vector<DialogueGraph> graphs[2] = {std::vector<DialogueGraph>(assets[0].size()), std::vector<DialogueGraph>(assets[1].size())};
+    std::vector<CacheRecord> keys[2] = {std::vector<CacheRecord>(assets[0].size()), std::vector<CacheRecord>(assets[1].size())};
+    {
+        unsigned int threads = std::thread::hardware_concurrency();
+        ThreadPool pool(threads > 0 ? threads : 4);
+        for (int side = 0; side < 2; ++side) {
+            for (size_t i = 0; i < assets[side].size(); ++i) {
+                pool.enqueue([&, side, i]() {
+                    process_dialogue_file(assets[side][i], graphs[side][i], keys[side][i], caches[side], &pool);
+                });
+            }
+        }
+    }
+
+    std::map<std::string, size_t> paired[2];
+    for (int side = 0; side < 2; ++side) {
+        for (size_t i = 0; i < assets[side].size(); ++i) {
+            paired[side].emplace(assets[side][i].lexically_relative(roots[side]).generic_string(), i);
+        }
+    }
+    std::vector<TextChange> changes;
+    size_t changed_graphs = 0;
+    std::set<std::string> names;
+    for (const auto& p : paired[0]) names.insert(p.first);
+    for (const auto& p : paired[1]) names.insert(p.first);
+    for (const auto& rel : names) {
+        auto o = paired[0].find(rel), n = paired[1].find(rel);
+        const DialogueGraph* before = o != paired[0].end() ? &graphs[0][o->second] : nullptr;
+        const DialogueGraph* after = n != paired[1].end() ? &graphs[1][n->second] : nullptr;
+        if (before && after && keys[0][o->second].hash == keys[1][n->second].hash &&
+            keys[0][o->second].size == keys[1][n->second].size && same_text(*before, *after)) {
+            continue;
+        }
+        size_t first = changes.size();
+        diff_graph(rel, before, after, changes);
+        if (changes.size() != first) changed_graphs++;
+    }
+
+    size_t counts[3] = {0, 0, 0};
+    static const char kMarks[] = {'+', '-', '~'};
+    for (const auto& c : changes) {
+        counts[c.kind]++;
+        std::cout << kMarks[c.kind] << " " << c.graph << " #" << c.node << ": ";
+        if (c.kind == TextChange::Modified) std::cout << c.old_text << "\n    -> " << c.new_text << std::endl;
+        else std::cout << (c.kind == TextChange::Added ? c.new_text : c.old_text) << std::endl;
+    }
+    std::cout << "Diff: " << counts[TextChange::Added] << " added, " << counts[TextChange::Removed] << " removed, "
+              << counts[TextChange::Modified] << " modified line(s) in " << changed_graphs << " graph(s)" << std::endl;
+
+    if (!json_out.empty()) {
+        std::ofstream jf(json_out);
+        if (!jf.is_open()) {
+            std::cerr << "Error: Could not open " << json_out << " for writing!" << std::endl;
+            return 1;
+        }
+        static const char* const kKinds[] = {"added", "removed", "modified"};
+        jf << "{\n  \"added\": " << counts[TextChange::Added]
+           << ",\n  \"removed\": " << counts[TextChange::Removed]
+           << ",\n  \"modified\": " << counts[TextChange::Modified]
+           << ",\n  \"changes\": [";
+        for (size_t i = 0; i < changes.size(); ++i) {
+            const auto& c = changes[i];
+            jf << (i ? "," : "") << "\n    {\"kind\": \"" << kKinds[c.kind] << "\", \"graph\": \"" << json_escape(c.graph)
+               << "\", \"node\": " << c.node;
+            if (c.kind != TextChange::Added) jf << ", \"old\": \"" << json_escape(c.old_text) << "\"";
+            if (c.kind != TextChange::Removed) jf << ", \"new\": \"" << json_escape(c.new_text) << "\"";
+            jf << "}";
+        }
+        jf << (changes.empty() ? "" : "\n  ") << "]\n}";
+        std::cout << "Report saved to: " << json_out << std::endl;
+    }
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
     std::string root_path = "";
     std::string json_out = "";
+    std::string guid_index_file = "";
+    std::string cache_file = "";
+    std::string base_locale = "";
+    bool use_cache = true;
+    std::vector<fs::path> dialogue_dirs, character_dirs;
+    std::string index_file = "";
+    std::string query = "";
+    bool build_index = false;
+    bool find_duplicates = false;
+    bool validate = false;
+    std::string export_file = "";
+    std::string diff_root = "";
+    std::string markup_file = "";
+    bool strip_markup = true;
+    bool include_demo = false;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--json" && i + 1 < argc) {
             json_out = argv[++i];
+        } else if (arg == "--guid-index" && i + 1 < argc) {
+            guid_index_file = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_file = argv[++i];
+        } else if (arg == "--base-locale" && i + 1 < argc) {
+            base_locale = argv[++i];
+        } else if (arg == "--dialogues" && i + 1 < argc) {
+            dialogue_dirs.push_back(argv[++i]);
+        } else if (arg == "--characters" && i + 1 < argc) {
+            character_dirs.push_back(argv[++i]);
+        } else if (arg == "--index" && i + 1 < argc) {
+            index_file = argv[++i];
+        } else if (arg == "--export" && i + 1 < argc) {
+            export_file = argv[++i];
+        } else if (arg == "--diff" && i + 1 < argc) {
+            diff_root = argv[++i];
+        } else if (arg == "--markup" && i + 1 < argc) {
+            markup_file = argv[++i];
+        } else if (arg == "--include-demo") {
+            include_demo = true;
+        } else if (arg == "--no-markup") {
+            strip_markup = false;
+        } else if (arg == "--validate") {
+            validate = true;
+        } else if (arg == "--duplicates") {
+            find_duplicates = true;
+        } else if (arg == "--build-index") {
+            build_index = true;
+        } else if (arg == "--query" && i + 1 < argc) {
+            query = argv[++i];
+        } else if (arg == "--no-cache") {
+            use_cache = false;
+        } else if (arg == "--no-chunking") {
+            chunked_parsing = false;
         } else if (arg[0] != '-') {
             root_path = arg;
         }
     }
 
-    if (root_path.empty()) {
-        std::cout << "Usage: novel_counter <path> [--json <output.json>]" << std::endl;
+    if (root_path.empty() && !(query.size() && index_file.size())) {
+        std::cout << "Usage: novel_counter <path> [--json <output.json>] [--guid-index <file>] [--cache <file> | --no-cache] [--base-locale <code>]\n"
+                  << "                     [--dialogues <dir>]... [--characters <dir>]... [--include-demo]\n"
+                  << "                     [--build-index] [--index <file>] [--duplicates] [--export <file.bytes>]\n"
+                  << "                     [--markup <grammar.txt> | --no-markup] [--no-chunking]\n"
+                  << "       novel_counter <path> --validate [--dialogues <dir>]...\n"
+                  << "       novel_counter <new_path> --diff <old_path> [--json <output.json>] [--dialogues <dir>]... [--characters <dir>]...\n"
+                  << "       novel_counter [<path>] --query <text|\"phrase\"> [--index <file>]" << std::endl;
         return 1;
     }
 
-    fs::path root = root_path;
-    fs::path diag_path, char_path;
-    bool d_f = false, c_f = false;
+    if (!strip_markup) {
+        text_markup.clear();
+    } else if (!markup_file.empty() && !text_markup.load(markup_file)) {
+        std::cerr << "Error: Could not read markup grammar " << markup_file << std::endl;
+        return 1;
+    }
 
-    for (const auto& entry : fs::recursive_directory_iterator(root)) {
-        if (entry.path().filename() == "Dialogues") { diag_path = entry.path(); d_f = true; }
-        if (entry.path().filename() == "Characters") { char_path = entry.path(); c_f = true; }
-        if (d_f && c_f) break;
+    // Discovery and the report keys work on absolute paths, so folders given relative to the
+    // working directory line up with the walk of the project.
+    auto absolute_dir = [](const fs::path& dir) {
+        std::error_code ec;
+        fs::path a = fs::absolute(dir, ec).lexically_normal();
+        return a.filename().empty() && a.has_parent_path() ? a.parent_path() : a;
+    };
+    fs::path root = root_path.empty() ? fs::path() : absolute_dir(root_path);
+    for (auto& d : dialogue_dirs) d = absolute_dir(d);
+    for (auto& c : character_dirs) c = absolute_dir(c);
+    if (index_file.empty()) {
+        index_file = (fs::is_directory(root / "Library") ? root / "Library" / "SNEngineTextIndex.bin" : root / "SNEngineTextIndex.bin").string();
     }
+    // A missing or damaged index is rebuilt from the project when there is one, then queried.
+    snengine::TextIndex text_index;
+    if (!query.empty()) {
+        if (text_index.load(index_file)) return run_query(text_index, query);
+        if (root_path.empty()) {
+            std::cerr << "Error: No valid text index at " << index_file << " (run with --build-index first)" << std::endl;
+            return 1;
+        }
+        std::cerr << "Text index " << index_file << " is missing or damaged, rebuilding" << std::endl;
+        build_index = true;
+    }
+    if (!diff_root.empty()) return run_diff(absolute_dir(diff_root), root, json_out, dialogue_dirs, character_dirs, include_demo);
 
-    if (!d_f) { std::cerr << "Error: No Dialogues folder!" << std::endl; return 1; }
+    ProjectLayout layout = scan_project(root, dialogue_dirs, character_dirs, include_demo);
+    if (layout.dialogue_roots.empty()) { std::cerr << "Error: No Dialogues folder!" << std::endl; return 1; }
 
-    size_t dialogue_graphs = 0;
-    std::vector<fs::path> assets_to_process;
-    for (const auto& entry : fs::recursive_directory_iterator(diag_path)) {
-        if (entry.path().extension() == ".asset") {
-            dialogue_graphs++;
-            assets_to_process.push_back(entry.path());
+    std::set<std::pair<size_t, std::string>> locale_folders = find_locale_folders(layout);
+    if (!locale_folders.empty()) {
+        std::cout << "Locale folders:";
+        for (const auto& l : locale_folders) {
+            std::cout << " " << (layout.dialogue_roots[l.first] / l.second).lexically_relative(root).generic_string();
         }
+        std::cout << std::endl;
     }
 
-    NovelStats stats;
+    // Overlapping --dialogues folders list a file more than once; each path is dispatched
+    // once, since workers move its cache record out by path.
+    std::vector<fs::path> assets_to_process;
+    std::vector<std::string> asset_locale, asset_rel;
+    std::unordered_set<std::string> listed;
+    for (const auto& a : layout.dialogue_assets) {
+        std::error_code aec;
+        if (!listed.insert(fs::absolute(a.first, aec).lexically_normal().generic_string()).second) continue;
+        const fs::path& dialogues_root = layout.dialogue_roots[a.second];
+        fs::path rel = a.first.lexically_relative(dialogues_root);
+        std::string first = rel.begin()->string();
+        bool localised = rel.has_parent_path() && locale_folders.count({a.second, first});
+        assets_to_process.push_back(a.first);
+        asset_locale.push_back(localised ? first : "default");
+        std::string key = dialogues_root.lexically_relative(root).generic_string() + "/";
+        asset_rel.push_back(key + (localised ? rel.lexically_relative(first).generic_string() : rel.generic_string()));
+    }
+    const std::vector<fs::path>& table_assets = layout.table_assets;
+    const std::vector<fs::path>& character_assets = layout.character_assets;
+    size_t char_assets = character_assets.size();
+
     unsigned int threads = std::thread::hardware_concurrency();
+    if (guid_index_file.empty() && fs::is_directory(root / "Library")) {
+        guid_index_file = (root / "Library" / "SNEngineGuidIndex.bin").string();
+    }
+    snengine::GuidIndex guids;
+    if (!guid_index_file.empty()) guids.load(guid_index_file);
+    guids.update(root, layout.meta_files, threads > 0 ? threads : 4);
+    if (!guid_index_file.empty() && guids.changed() && !guids.save(guid_index_file)) {
+        std::cerr << "Warning: Could not write GUID index " << guid_index_file << std::endl;
+    }
+
+    if (!use_cache) {
+        cache_file.clear();
+    } else if (cache_file.empty() && fs::is_directory(root / "Library")) {
+        cache_file = (root / "Library" / "SNEngineNovelCache.bin").string();
+    }
+    std::unordered_map<std::string, CacheRecord> cache;
+    if (!cache_file.empty()) cache = load_novel_cache(cache_file);
+
+    std::vector<DialogueGraph> graphs(assets_to_process.size());
+    std::vector<CacheRecord> cache_keys(assets_to_process.size());
+    std::vector<StringTable> tables(table_assets.size());
+    std::vector<std::vector<TextSignature>> signatures(find_duplicates ? assets_to_process.size() : 0);
+    std::vector<std::vector<GraphIssue>> issues(validate ? assets_to_process.size() : 0);
+    std::atomic<size_t> parsed_graphs{0};
     {
         ThreadPool pool(threads > 0 ? threads : 4);
-        for (const auto& p : assets_to_process) {
-            pool.enqueue([&stats, p]() { process_dialogue_file(p, stats); });
+        for (size_t i = 0; i < assets_to_process.size(); ++i) {
+            pool.enqueue([&, i]() {
+                if (process_dialogue_file(assets_to_process[i], graphs[i], cache_keys[i], cache, &pool)) parsed_graphs++;
+                if (validate) issues[i] = validate_graph(graphs[i]);
+                if (find_duplicates) graph_signatures(graphs[i], static_cast<uint32_t>(i), signatures[i]);
+            });
+        }
+        for (size_t i = 0; i < table_assets.size(); ++i) {
+            pool.enqueue([&, i]() { parse_string_table(table_assets[i], tables[i]); });
+        }
+    }
+    // The cache is rewritten only when a graph was re-parsed, added, removed or touched.
+    bool cache_dirty = parsed_graphs > 0 || cache.size() != graphs.size();
+    for (size_t i = 0; i < graphs.size() && !cache_dirty; ++i) {
+        auto it = cache.find(graphs[i].path.generic_string());
+        cache_dirty = it == cache.end() || it->second.size != cache_keys[i].size || it->second.mtime != cache_keys[i].mtime;
+    }
+    if (!cache_file.empty() && cache_dirty && !save_novel_cache(cache_file, graphs, cache_keys)) {
+        std::cerr << "Warning: Could not write analysis cache " << cache_file << std::endl;
+    }
+    if (validate) {
+        static const char* const kIssueNames[] = {"unreachable node", "connection to missing node", "dead end"};
+        size_t total = 0, broken = 0;
+        for (size_t i = 0; i < graphs.size(); ++i) {
+            if (issues[i].empty()) continue;
+            broken++;
+            std::string where = graphs[i].path.lexically_relative(root).generic_string();
+            for (const auto& issue : issues[i]) {
+                std::cout << where << ": " << kIssueNames[issue.kind] << " #" << issue.node;
+                if (!issue.name.empty()) std::cout << " (" << issue.name << ")";
+                if (issue.kind == GraphIssue::DanglingConnection) std::cout << " -> #" << issue.target;
+                std::cout << std::endl;
+                total++;
+            }
+        }
+        std::cout << "Validated " << graphs.size() << " graph(s): " << total << " issue(s) in " << broken << " graph(s)" << std::endl;
+        return total ? 1 : 0;
+    }
+
+    assign_graph_guids(graphs, root, guids);
+    CharacterIndex characters = build_character_index(character_assets, root, guids, graphs);
+
+    if (!export_file.empty()) {
+        std::string error;
+        if (!export_blob(export_file, graphs, root, characters)) {
+            std::cerr << "Error: Could not write " << export_file << std::endl;
+            return 1;
+        }
+        if (!verify_blob(export_file, graphs, error)) {
+            std::cerr << "Error: Export round-trip failed: " << error << std::endl;
+            return 1;
+        }
+        std::cout << "Exported " << graphs.size() << " graph(s) to " << export_file << " (" << fs::file_size(export_file)
+                  << " bytes), round-trip verified" << std::endl;
+    }
+    // An existing index is kept current: its header holds a hash of the graph paths, their
+    // contents and the markup grammar, and any difference rebuilds it, whichever run parsed them.
+    uint64_t index_hash = text_markup.fingerprint();
+    for (size_t i = 0; i < graphs.size(); ++i) {
+        index_hash = mix64(index_hash ^ content_hash(graphs[i].path.lexically_relative(root).generic_string()));
+        index_hash = mix64(index_hash ^ cache_keys[i].hash);
+    }
+    uint64_t stored_hash = 0;
+    bool index_stale = !snengine::TextIndex::stored_hash(index_file, stored_hash) || stored_hash != index_hash;
+    if (build_index || (index_stale && fs::exists(index_file))) {
+        snengine::TextIndexBuilder builder;
+        for (const auto& g : graphs) {
+            uint32_t id = builder.add_graph(g.path.lexically_relative(root).generic_string());
+            for (const auto& n : g.nodes) {
+                size_t markup = 0;
+                for (const auto& t : n.texts) builder.add_text(id, n.file_id, text_markup.strip(t, markup));
+            }
+        }
+        bool unchanged = false;
+        if (builder.write(index_file, index_hash, &unchanged)) {
+            std::cout << "Text index: " << builder.doc_count() << " lines, " << builder.term_count() << " terms -> "
+                      << index_file << (unchanged ? " (up to date)" : "") << std::endl;
+        } else {
+            std::cerr << "Error: Could not write text index " << index_file << std::endl;
         }
     }
+    if (!query.empty()) {
+        if (!text_index.load(index_file)) return 1;
+        return run_query(text_index, query);
+    }
+
+    const std::string requested_locale = base_locale;
+    std::vector<LocaleReport> locales = build_locale_reports(graphs, asset_locale, asset_rel, tables, base_locale);
+    if (!requested_locale.empty() && base_locale != requested_locale) {
+        std::cerr << "Warning: Base locale " << requested_locale << " not found, using " << base_locale << std::endl;
+    }
 
-    size_t char_assets = 0;
-    if (c_f) {
-        for (const auto& entry : fs::directory_iterator(char_path)) {
-            if (entry.path().extension() == ".asset") char_assets++;
+    NovelStats stats;
+    std::vector<const DialogueGraph*> base_graphs;
+    for (size_t i = 0; i < graphs.size(); ++i) {
+        if (asset_locale[i] != base_locale) continue;
+        base_graphs.push_back(&graphs[i]);
+        add_graph_stats(graphs[i], stats);
+    }
+    size_t dialogue_graphs = base_graphs.size();
+    RouteLength routes = estimate_routes(base_graphs);
+    std::vector<SpeakerStats> speakers = aggregate_speakers(base_graphs, characters);
+    std::vector<std::vector<size_t>> graph_types;
+    std::vector<NodeType> node_types = node_type_histogram(base_graphs, guids, graph_types);
+    std::vector<size_t> type_order(node_types.size());
+    for (size_t i = 0; i < type_order.size(); ++i) type_order[i] = i;
+    std::sort(type_order.begin(), type_order.end(), [&](size_t a, size_t b) { return node_types[a].count > node_types[b].count; });
+    bool multi_locale = locales.size() > 1 || !tables.empty();
+
+    std::vector<std::vector<TextRef>> duplicates;
+    if (find_duplicates) {
+        std::vector<TextSignature> base_signatures;
+        for (size_t i = 0; i < signatures.size(); ++i) {
+            if (asset_locale[i] != base_locale) continue;
+            base_signatures.insert(base_signatures.end(), signatures[i].begin(), signatures[i].end());
+            std::vector<TextSignature>().swap(signatures[i]);
         }
+        duplicates = find_near_duplicates(base_signatures);
     }
+    auto text_of = [&](const TextRef& r) -> const std::string& { return graphs[r.graph].nodes[r.node].texts[r.text]; };
+    auto place_of = [&](const TextRef& r) {
+        return graphs[r.graph].path.lexically_relative(root).generic_string() + " #" + std::to_string(graphs[r.graph].nodes[r.node].file_id);
+    };
 
     double playtime_mins = (stats.total_chars / 800.0 * 1.2) + (stats.total_wait_seconds / 60.0);
     size_t avg = (stats.total_sentences ? stats.total_chars / stats.total_sentences : 0);
@@ -217,7 +2293,61 @@ int main(int argc, char* argv[]) {
     std::cout << "Total Nodes:     " << stats.total_nodes << std::endl;
     std::cout << "Text Blocks:     " << stats.dialogue_nodes << std::endl;
     std::cout << "Chars (Unicode): " << stats.total_chars << std::endl;
-    std::cout << "Playtime:        " << (int)playtime_mins / 60 << "h " << (int)playtime_mins % 60 << "m" << std::endl;
+    std::cout << "Words:           " << stats.total_words << std::endl;
+    std::cout << "Markup Chars:    " << stats.markup_chars << std::endl;
+    std::cout << "Playtime:        " << format_minutes(routes.expected) << std::endl;
+    std::cout << "Shortest Route:  " << format_minutes(routes.shortest) << std::endl;
+    std::cout << "Longest Route:   " << format_minutes(routes.longest) << std::endl;
+    std::cout << "All Content:     " << format_minutes(playtime_mins) << std::endl;
+    if (!cache_file.empty()) {
+        std::cout << "Cache:           " << (graphs.size() - parsed_graphs) << " reused, " << parsed_graphs << " parsed" << std::endl;
+    }
+
+    if (multi_locale) {
+        const char* chosen = base_locale == requested_locale ? "" : base_locale == "default" ? ", untranslated text" : ", largest locale";
+        std::cout << "\n--- Locales (base: " << base_locale << chosen << ") ---" << std::endl;
+        const std::ios_base::fmtflags flags = std::cout.flags();
+        const std::streamsize precision = std::cout.precision();
+        for (const auto& l : locales) {
+            std::cout << std::left << std::setw(10) << l.code << std::right
+                      << " chars: " << std::setw(8) << l.chars
+                      << " words: " << std::setw(7) << l.words
+                      << " sentences: " << std::setw(6) << l.sentences
+                      << " playtime: " << std::setw(7) << format_minutes(l.playtime_minutes)
+                      << " coverage: " << std::fixed << std::setprecision(1) << l.coverage * 100.0 << "%" << std::endl;
+        }
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    if (find_duplicates) {
+        const size_t shown = std::min<size_t>(duplicates.size(), 20);
+        std::cout << "\n--- Near-Duplicate Lines: " << duplicates.size() << " cluster(s) ---" << std::endl;
+        for (size_t c = 0; c < shown; ++c) {
+            std::cout << "[" << c + 1 << "] " << duplicates[c].size() << " lines" << std::endl;
+            for (const auto& r : duplicates[c]) std::cout << "    " << place_of(r) << ": " << text_of(r) << std::endl;
+        }
+        if (shown < duplicates.size()) std::cout << "... " << duplicates.size() - shown << " more in the JSON report" << std::endl;
+    }
+
+    if (!node_types.empty()) {
+        std::cout << "\n--- Node Types ---" << std::endl;
+        for (size_t i : type_order) {
+            std::cout << std::left << std::setw(32) << node_types[i].script << std::setw(10) << node_types[i].category
+                      << std::right << std::setw(8) << node_types[i].count << std::endl;
+        }
+    }
+
+    if (!speakers.empty()) {
+        std::cout << "\n--- Speakers ---" << std::endl;
+        for (const auto& s : speakers) {
+            std::cout << std::left << std::setw(24) << s.name << std::right
+                      << " lines: " << std::setw(6) << s.lines
+                      << " chars: " << std::setw(8) << s.chars
+                      << " sentences: " << std::setw(6) << s.sentences
+                      << " wait: " << s.wait_seconds << "s" << std::endl;
+        }
+    }
 
     if (!json_out.empty()) {
         std::ofstream jf(json_out);
@@ -228,8 +2358,76 @@ int main(int argc, char* argv[]) {
                << "  \"nodes\": " << stats.total_nodes << ",\n"
                << "  \"dialogues\": " << stats.dialogue_nodes << ",\n"
                << "  \"chars\": " << stats.total_chars << ",\n"
-               << "  \"estimated_playtime_minutes\": " << std::fixed << std::setprecision(2) << playtime_mins << "\n"
-               << "}";
+               << "  \"words\": " << stats.total_words << ",\n"
+               << "  \"markup_chars\": " << stats.markup_chars << ",\n"
+               << "  \"estimated_playtime_minutes\": " << std::fixed << std::setprecision(2) << playtime_mins << ",\n"
+               << "  \"playthrough\": {\n"
+               << "    \"shortest_minutes\": " << routes.shortest << ",\n"
+               << "    \"expected_minutes\": " << routes.expected << ",\n"
+               << "    \"longest_minutes\": " << routes.longest << "\n"
+               << "  },\n"
+               << "  \"speakers\": [";
+            for (size_t i = 0; i < speakers.size(); ++i) {
+                const auto& sp = speakers[i];
+                jf << (i ? "," : "") << "\n    {\"name\": \"" << json_escape(sp.name) << "\""
+                   << ", \"lines\": " << sp.lines
+                   << ", \"chars\": " << sp.chars
+                   << ", \"sentences\": " << sp.sentences
+                   << ", \"wait_seconds\": " << sp.wait_seconds << "}";
+            }
+            jf << (speakers.empty() ? "" : "\n  ") << "]";
+            jf << ",\n  \"node_types\": [";
+            for (size_t k = 0; k < type_order.size(); ++k) {
+                const NodeType& t = node_types[type_order[k]];
+                jf << (k ? "," : "") << "\n    {\"script\": \"" << json_escape(t.script) << "\""
+                   << ", \"path\": \"" << json_escape(t.path) << "\""
+                   << ", \"guid\": \"" << t.guid << "\""
+                   << ", \"category\": \"" << t.category << "\""
+                   << ", \"count\": " << t.count << "}";
+            }
+            jf << (type_order.empty() ? "" : "\n  ") << "],\n  \"node_types_by_graph\": [";
+            for (size_t g = 0; g < base_graphs.size(); ++g) {
+                jf << (g ? "," : "") << "\n    {\"graph\": \"" << json_escape(base_graphs[g]->path.lexically_relative(root).generic_string()) << "\", \"types\": {";
+                bool first = true;
+                for (size_t i : type_order) {
+                    if (!graph_types[g][i]) continue;
+                    jf << (first ? "" : ", ") << "\"" << json_escape(node_types[i].path) << "\": " << graph_types[g][i];
+                    first = false;
+                }
+                jf << "}}";
+            }
+            jf << (base_graphs.empty() ? "" : "\n  ") << "]";
+            if (multi_locale) {
+                jf << ",\n  \"base_locale\": \"" << json_escape(base_locale) << "\",\n  \"locales\": [";
+                for (size_t i = 0; i < locales.size(); ++i) {
+                    const auto& l = locales[i];
+                    jf << (i ? "," : "") << "\n    {\"code\": \"" << json_escape(l.code) << "\""
+                       << ", \"graphs\": " << l.graphs
+                       << ", \"table_entries\": " << l.table_entries
+                       << ", \"text_blocks\": " << l.text_blocks
+                       << ", \"chars\": " << l.chars
+                       << ", \"words\": " << l.words
+                       << ", \"sentences\": " << l.sentences
+                       << ", \"playtime_minutes\": " << l.playtime_minutes
+                       << ", \"coverage\": " << std::setprecision(4) << l.coverage << std::setprecision(2) << "}";
+                }
+                jf << "\n  ]";
+            }
+            if (find_duplicates) {
+                jf << ",\n  \"duplicates\": [";
+                for (size_t c = 0; c < duplicates.size(); ++c) {
+                    jf << (c ? "," : "") << "\n    [";
+                    for (size_t k = 0; k < duplicates[c].size(); ++k) {
+                        const TextRef& r = duplicates[c][k];
+                        jf << (k ? ", " : "") << "{\"graph\": \"" << json_escape(graphs[r.graph].path.lexically_relative(root).generic_string())
+                           << "\", \"node\": " << graphs[r.graph].nodes[r.node].file_id
+                           << ", \"text\": \"" << json_escape(text_of(r)) << "\"}";
+                    }
+                    jf << "]";
+                }
+                jf << (duplicates.empty() ? "" : "\n  ") << "]";
+            }
+            jf << "\n}";
             std::cout << "Report saved to: " << json_out << std::endl;
         } else {
             std::cerr << "Error: Could not open " << json_out << " for writing!" << std::endl;
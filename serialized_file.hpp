@@ -0,0 +1,397 @@
+#pragma once
+
+// Reader for Unity binary SerializedFile assets ("Force Binary" serialization).
+//
+// Parses the header, the type table with its type trees, the object table and the
+// externals list (the GUIDs that PPtr m_FileID values index into), then walks object
+// data by type tree and reports field values to a visitor. Only the embedded-type-tree
+// layout used by editor assets (format version 12 and later) is supported; player
+// builds strip type trees and are rejected with an error.
+//
+// A visitor provides:
+//   void on_string(std::string_view field, std::string_view value);
+//   void on_number(std::string_view field, double value);
+//   void on_pptr(std::string_view field, int32_t file_id, int64_t path_id);
+//   void on_array(std::string_view field, int32_t count);
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+
+namespace snengine {
+
+// Unity's built-in type tree strings; offsets with the high bit set index into this buffer.
+const char kUnityCommonStrings[] =
+    "AABB\0AnimationClip\0AnimationCurve\0AnimationState\0Array\0Base\0BitField\0bitset\0bool\0char\0"
+    "ColorRGBA\0Component\0data\0deque\0double\0dynamic_array\0FastPropertyName\0first\0float\0Font\0"
+    "GameObject\0Generic Mono\0GradientNEW\0GUID\0GUIStyle\0int\0list\0long long\0map\0Matrix4x4f\0MdFour\0"
+    "MonoBehaviour\0MonoScript\0m_ByteSize\0m_Curve\0m_EditorClassIdentifier\0m_EditorHideFlags\0m_Enabled\0"
+    "m_ExtensionPtr\0m_GameObject\0m_Index\0m_IsArray\0m_IsStatic\0m_MetaFlag\0m_Name\0m_ObjectHideFlags\0"
+    "m_PrefabInternal\0m_PrefabParentObject\0m_Script\0m_StaticEditorFlags\0m_Type\0m_Version\0Object\0pair\0"
+    "PPtr<Component>\0PPtr<GameObject>\0PPtr<Material>\0PPtr<MonoBehaviour>\0PPtr<MonoScript>\0PPtr<Object>\0"
+    "PPtr<Prefab>\0PPtr<Sprite>\0PPtr<TextAsset>\0PPtr<Texture>\0PPtr<Texture2D>\0PPtr<Transform>\0Prefab\0"
+    "Quaternionf\0Rectf\0RectInt\0RectOffset\0second\0set\0short\0size\0SInt16\0SInt32\0SInt64\0SInt8\0"
+    "staticvector\0string\0TextAsset\0TextMesh\0Texture\0Texture2D\0Transform\0TypelessData\0UInt16\0UInt32\0"
+    "UInt64\0UInt8\0unsigned int\0unsigned long long\0unsigned short\0vector\0Vector2f\0Vector3f\0Vector4f\0"
+    "m_ScriptingClassIdentifier\0Gradient\0Type*\0int2_storage\0int3_storage\0BoundsInt\0"
+    "m_CorrespondingSourceObject\0m_PrefabInstance\0m_PrefabAsset\0FileSize\0Hash128";
+
+struct TypeTreeNode {
+    std::string type;
+    std::string name;
+    int32_t byte_size = 0;
+    uint32_t meta_flag = 0;
+    uint8_t level = 0;
+    uint8_t flags = 0;
+    uint32_t end = 0; // index one past this node's subtree
+};
+
+struct SerializedType {
+    int32_t class_id = 0;
+    std::vector<TypeTreeNode> tree;
+};
+
+struct SerializedObject {
+    int64_t path_id = 0;
+    uint64_t offset = 0;
+    uint32_t size = 0;
+    int32_t class_id = 0;
+    uint32_t type = 0;
+};
+
+class SerializedFile {
+public:
+    static constexpr uint32_t kAlignFlag = 0x4000;
+
+    // Text assets start with "%YAML"; binary ones with a big-endian header whose third
+    // word is the format version.
+    static bool detect(const char* data, size_t size) {
+        if (size < 20 || data[0] == '%') return false;
+        uint32_t version = (uint32_t(uint8_t(data[8])) << 24) | (uint32_t(uint8_t(data[9])) << 16) |
+                           (uint32_t(uint8_t(data[10])) << 8) | uint8_t(data[11]);
+        return version >= 5 && version < 100;
+    }
+
+    bool open(const char* data, size_t size) {
+        data_ = data;
+        size_ = size;
+        types_.clear();
+        objects_.clear();
+        externals_.clear();
+        Reader r(data, size, true);
+        r.get<uint32_t>(); // metadata size
+        uint64_t file_size = r.get<uint32_t>();
+        version_ = r.get<uint32_t>();
+        data_offset_ = r.get<uint32_t>();
+        if (version_ < 12) return fail("unsupported SerializedFile version " + std::to_string(version_));
+        r.big = r.get<uint8_t>() != 0;
+        r.skip(3);
+        if (version_ >= 22) {
+            bool big = r.big;
+            r.big = true;
+            r.get<uint32_t>();
+            file_size = r.get<uint64_t>();
+            data_offset_ = r.get<uint64_t>();
+            r.skip(8);
+            r.big = big;
+        }
+        if (!r.ok || file_size > size || data_offset_ > size) return fail("truncated header");
+        big_ = r.big;
+
+        r.cstr();
+        r.get<int32_t>();
+        bool type_trees = version_ < 13 || r.get<uint8_t>() != 0;
+        if (!type_trees) return fail("asset has no type trees");
+        int32_t type_count = r.get<int32_t>();
+        if (!r.ok || type_count < 0 || size_t(type_count) > (size - r.pos) / 12) return fail("bad type table");
+        types_.resize(type_count);
+        for (auto& t : types_) {
+            if (!read_type(r, t)) return fail("bad type tree");
+        }
+        if (version_ < 14) r.get<int32_t>();
+
+        int32_t object_count = r.get<int32_t>();
+        if (!r.ok || object_count < 0 || size_t(object_count) > (size - r.pos) / 20) return fail("bad object table");
+        objects_.resize(object_count);
+        for (auto& o : objects_) {
+            if (version_ >= 14) {
+                r.align();
+                o.path_id = r.get<int64_t>();
+            } else {
+                o.path_id = r.get<int32_t>();
+            }
+            o.offset = (version_ >= 22 ? r.get<uint64_t>() : r.get<uint32_t>()) + data_offset_;
+            o.size = r.get<uint32_t>();
+            int32_t type = r.get<int32_t>();
+            if (version_ < 16) {
+                o.class_id = r.get<uint16_t>();
+                type = find_type(type);
+            }
+            if (version_ < 17) r.get<int16_t>();
+            if (version_ == 15 || version_ == 16) r.get<uint8_t>();
+            if (!r.ok || type < 0 || size_t(type) >= types_.size() || o.offset > size || o.size > size - o.offset) {
+                return fail("bad object entry");
+            }
+            o.type = static_cast<uint32_t>(type);
+            if (version_ >= 16) o.class_id = types_[o.type].class_id;
+        }
+
+        int32_t script_count = r.get<int32_t>();
+        for (int32_t i = 0; r.ok && i < script_count; ++i) {
+            r.get<int32_t>();
+            if (version_ >= 14) {
+                r.align();
+                r.get<int64_t>();
+            } else {
+                r.get<int32_t>();
+            }
+        }
+        int32_t external_count = r.get<int32_t>();
+        for (int32_t i = 0; r.ok && i < external_count; ++i) {
+            r.cstr();
+            const char* guid = r.bytes(16);
+            r.get<int32_t>();
+            r.cstr();
+            if (guid) externals_.push_back(guid_string(guid));
+        }
+        if (!r.ok) return fail("bad externals table");
+        return true;
+    }
+
+    const std::string& error() const { return error_; }
+    uint32_t version() const { return version_; }
+    const std::vector<SerializedObject>& objects() const { return objects_; }
+
+    // Hex GUID of the file a PPtr m_FileID points into; empty for the file itself.
+    std::string external_guid(int32_t file_id) const {
+        return file_id > 0 && size_t(file_id) <= externals_.size() ? externals_[file_id - 1] : std::string();
+    }
+
+    template <typename Visitor>
+    bool read_object(const SerializedObject& object, Visitor& visitor) const {
+        const SerializedType& t = types_[object.type];
+        if (t.tree.empty()) return false;
+        Reader r(data_ + object.offset, object.size, big_);
+        return read_node(r, t, 0, visitor, 0) && r.ok;
+    }
+
+private:
+    struct Reader {
+        Reader(const char* p, size_t n, bool big) : p(p), n(n), big(big) {}
+        template <typename T> T get() {
+            T v{};
+            if (!ok || n - pos < sizeof(T)) { ok = false; return v; }
+            unsigned char b[sizeof(T)];
+            std::memcpy(b, p + pos, sizeof(T));
+            if (big) {
+                for (size_t i = 0; i < sizeof(T) / 2; ++i) std::swap(b[i], b[sizeof(T) - 1 - i]);
+            }
+            std::memcpy(&v, b, sizeof(T));
+            pos += sizeof(T);
+            return v;
+        }
+        const char* bytes(size_t count) {
+            if (!ok || n - pos < count) { ok = false; return nullptr; }
+            const char* out = p + pos;
+            pos += count;
+            return out;
+        }
+        void skip(size_t count) { bytes(count); }
+        std::string cstr() {
+            const void* z = ok ? std::memchr(p + pos, '\0', n - pos) : nullptr;
+            if (!z) { ok = false; return std::string(); }
+            std::string s(p + pos, static_cast<const char*>(z));
+            pos += s.size() + 1;
+            return s;
+        }
+        void align() {
+            size_t aligned = (pos + 3) & ~size_t(3);
+            if (aligned > n) ok = false; else pos = aligned;
+        }
+        const char* p;
+        size_t n;
+        size_t pos = 0;
+        bool big;
+        bool ok = true;
+    };
+
+    bool fail(const std::string& message) {
+        error_ = message;
+        return false;
+    }
+
+    // Before version 16 objects store a type ID (the class ID, negative for scripts)
+    // instead of an index into the type table.
+    int32_t find_type(int32_t type_id) const {
+        for (size_t i = 0; i < types_.size(); ++i) {
+            if (types_[i].class_id == type_id) return static_cast<int32_t>(i);
+        }
+        return -1;
+    }
+
+    // Unity prints each GUID byte low nibble first.
+    static std::string guid_string(const char* raw) {
+        static const char digits[] = "0123456789abcdef";
+        std::string out(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            uint8_t b = static_cast<uint8_t>(raw[i]);
+            out[i * 2] = digits[b & 0xF];
+            out[i * 2 + 1] = digits[b >> 4];
+        }
+        return out;
+    }
+
+    bool read_type(Reader& r, SerializedType& t) {
+        t.class_id = r.get<int32_t>();
+        if (version_ >= 16) r.get<uint8_t>();
+        if (version_ >= 17) r.get<int16_t>();
+        if (version_ >= 13) {
+            if ((version_ < 16 && t.class_id < 0) || (version_ >= 16 && t.class_id == 114)) r.skip(16);
+            r.skip(16);
+        }
+        int32_t node_count = r.get<int32_t>();
+        int32_t strings_size = r.get<int32_t>();
+        const size_t node_bytes = version_ >= 19 ? 32 : 24;
+        if (!r.ok || node_count < 0 || strings_size < 0 || size_t(node_count) > (r.n - r.pos) / node_bytes) return false;
+        Reader nodes(r.bytes(node_count * node_bytes), node_count * node_bytes, r.big);
+        const char* strings = r.bytes(strings_size);
+        if (!r.ok) return false;
+        auto str = [&](uint32_t offset) {
+            if (offset & 0x80000000u) {
+                offset &= 0x7FFFFFFFu;
+                return offset < sizeof(kUnityCommonStrings) ? std::string(kUnityCommonStrings + offset) : std::string();
+            }
+            if (offset >= uint32_t(strings_size)) return std::string();
+            const char* s = strings + offset;
+            const void* z = std::memchr(s, '\0', strings_size - offset);
+            return std::string(s, z ? static_cast<const char*>(z) : strings + strings_size);
+        };
+        t.tree.resize(node_count);
+        for (auto& node : t.tree) {
+            nodes.get<uint16_t>();
+            node.level = nodes.get<uint8_t>();
+            node.flags = nodes.get<uint8_t>();
+            node.type = str(nodes.get<uint32_t>());
+            node.name = str(nodes.get<uint32_t>());
+            node.byte_size = nodes.get<int32_t>();
+            nodes.get<int32_t>();
+            node.meta_flag = nodes.get<uint32_t>();
+            if (version_ >= 19) nodes.get<uint64_t>();
+        }
+        for (size_t i = t.tree.size(); i-- > 0;) {
+            size_t end = i + 1;
+            while (end < t.tree.size() && t.tree[end].level > t.tree[i].level) end = t.tree[end].end;
+            t.tree[i].end = static_cast<uint32_t>(end);
+        }
+        if (version_ >= 21) {
+            int32_t deps = r.get<int32_t>();
+            if (deps < 0) return false;
+            r.skip(size_t(deps) * 4);
+        }
+        return r.ok;
+    }
+
+    static bool is_array(const TypeTreeNode& n) { return (n.flags & 1) || n.type == "Array"; }
+
+    static bool read_number(Reader& r, const TypeTreeNode& n, double& out) {
+        const std::string& t = n.type;
+        switch (n.byte_size) {
+        case 1: out = t == "SInt8" ? double(r.get<int8_t>()) : double(r.get<uint8_t>()); break;
+        case 2: out = (t == "SInt16" || t == "short") ? double(r.get<int16_t>()) : double(r.get<uint16_t>()); break;
+        case 4:
+            if (t == "float") out = r.get<float>();
+            else if (t == "int" || t == "SInt32") out = r.get<int32_t>();
+            else out = r.get<uint32_t>();
+            break;
+        case 8:
+            if (t == "double") out = r.get<double>();
+            else if (t == "SInt64" || t == "long long") out = double(r.get<int64_t>());
+            else out = double(r.get<uint64_t>());
+            break;
+        default:
+            if (n.byte_size <= 0) return false;
+            r.skip(n.byte_size);
+            out = 0.0;
+        }
+        return r.ok;
+    }
+
+    template <typename Visitor>
+    bool read_array(Reader& r, const SerializedType& t, size_t array, const std::string& field, Visitor& v, size_t depth) const {
+        const TypeTreeNode& a = t.tree[array];
+        size_t size_node = array + 1;
+        if (size_node >= a.end || t.tree[size_node].end >= a.end) return false;
+        size_t data_node = t.tree[size_node].end;
+        int32_t count = r.get<int32_t>();
+        if (!r.ok || count < 0 || size_t(count) > r.n - r.pos) return false;
+        v.on_array(field, count);
+        const TypeTreeNode& d = t.tree[data_node];
+        if (d.end == data_node + 1 && d.byte_size > 0 && d.type != "string") {
+            r.skip(size_t(count) * d.byte_size);
+        } else {
+            for (int32_t i = 0; i < count && r.ok; ++i) {
+                if (!read_node(r, t, data_node, v, depth + 1)) return false;
+            }
+        }
+        if (a.meta_flag & kAlignFlag) r.align();
+        return r.ok;
+    }
+
+    template <typename Visitor>
+    bool read_node(Reader& r, const SerializedType& t, size_t i, Visitor& v, size_t depth) const {
+        const TypeTreeNode& n = t.tree[i];
+        if (depth > 64) return false;
+        const bool leaf = n.end == i + 1;
+        if (n.type == "string") {
+            int32_t length = r.get<int32_t>();
+            const char* s = length >= 0 ? r.bytes(length) : nullptr;
+            if (!s) return false;
+            v.on_string(n.name, std::string_view(s, length));
+            if (!leaf && (t.tree[i + 1].meta_flag & kAlignFlag)) r.align();
+        } else if (n.type == "TypelessData") {
+            int32_t length = r.get<int32_t>();
+            if (length < 0) return false;
+            r.skip(length);
+        } else if (leaf) {
+            double value = 0.0;
+            if (!read_number(r, n, value)) return false;
+            v.on_number(n.name, value);
+        } else if (n.type.compare(0, 5, "PPtr<") == 0) {
+            int32_t file_id = 0;
+            int64_t path_id = 0;
+            for (size_t c = i + 1; c < n.end; c = t.tree[c].end) {
+                const TypeTreeNode& child = t.tree[c];
+                double ignored = 0.0;
+                if (child.name == "m_FileID") file_id = r.get<int32_t>();
+                else if (child.name == "m_PathID") path_id = child.byte_size == 8 ? r.get<int64_t>() : r.get<int32_t>();
+                else if (!read_number(r, child, ignored)) return false;
+            }
+            v.on_pptr(n.name, file_id, path_id);
+        } else if (is_array(n)) {
+            if (!read_array(r, t, i, n.name, v, depth)) return false;
+        } else if (is_array(t.tree[i + 1])) {
+            if (!read_array(r, t, i + 1, n.name, v, depth)) return false;
+        } else {
+            for (size_t c = i + 1; c < n.end; c = t.tree[c].end) {
+                if (!read_node(r, t, c, v, depth + 1)) return false;
+            }
+        }
+        if (n.meta_flag & kAlignFlag) r.align();
+        return r.ok;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    uint32_t version_ = 0;
+    uint64_t data_offset_ = 0;
+    bool big_ = false;
+    std::vector<SerializedType> types_;
+    std::vector<SerializedObject> objects_;
+    std::vector<std::string> externals_;
+    std::string error_;
+};
+
+}
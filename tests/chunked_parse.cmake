@@ -0,0 +1,48 @@
+# Checks the chunked parallel YAML parser of SNEngine_Novel_Counter against a single-pass
+# parse: a dialogue of a few megabytes is generated from tests/fixtures/dialogue_step.asset.in
+# and both JSON reports must be identical.
+#
+#   cmake -DCOUNTER=<SNEngine_Novel_Counter> -DSTEP=<dialogue_step.asset.in> -DWORK=<dir> -P chunked_parse.cmake
+
+set(STEPS 1500)
+file(REMOVE_RECURSE "${WORK}")
+file(MAKE_DIRECTORY "${WORK}/Assets/Dialogues")
+file(READ "${STEP}" template)
+
+set(asset "%YAML 1.1\n%TAG !u! tag:unity3d.com,2011:\n--- !u!114 &11400000\nMonoBehaviour:\n")
+string(APPEND asset "  m_Script: {fileID: 11500000, guid: 99990000000000000000000000000000, type: 3}\n  m_Name: Long\n")
+string(APPEND asset "--- !u!114 &100\nMonoBehaviour:\n")
+string(APPEND asset "  m_Script: {fileID: 11500000, guid: 5ad00000000000000000000000000001, type: 3}\n  m_Name: Start\n")
+string(APPEND asset "  ports:\n    values:\n    - _fieldName: _exit\n      connections:\n      - fieldName: _enter\n")
+string(APPEND asset "        node: {fileID: 1000}\n        reroutePoints: []\n      _direction: 1\n")
+foreach(STEP_INDEX RANGE 1 ${STEPS})
+    math(EXPR CHOICE "${STEP_INDEX} * 10 + 990")
+    math(EXPR A "${CHOICE} + 1")
+    math(EXPR B "${CHOICE} + 2")
+    math(EXPR NEXT "${CHOICE} + 10")
+    set(STEP ${STEP_INDEX})
+    string(CONFIGURE "${template}" node @ONLY)
+    string(APPEND asset "${node}")
+endforeach()
+file(WRITE "${WORK}/Assets/Dialogues/Long.asset" "${asset}")
+
+foreach(mode chunked single)
+    set(extra)
+    if(mode STREQUAL "single")
+        set(extra --no-chunking)
+    endif()
+    execute_process(COMMAND "${COUNTER}" "${WORK}" --no-cache --guid-index "${WORK}/guids.bin" --json "${WORK}/${mode}.json" ${extra}
+                    OUTPUT_QUIET RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "SNEngine_Novel_Counter (${mode}) failed: ${result}")
+    endif()
+endforeach()
+
+execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${WORK}/chunked.json" "${WORK}/single.json" RESULT_VARIABLE differ)
+if(differ)
+    message(FATAL_ERROR "Chunked and single-pass parses differ: ${WORK}/chunked.json vs ${WORK}/single.json")
+endif()
+file(READ "${WORK}/single.json" report)
+if(NOT report MATCHES "\"nodes\": 4502,")
+    message(FATAL_ERROR "Unexpected node count in ${WORK}/single.json")
+endif()
@@ -0,0 +1,375 @@
+// Writes a small dialogue graph as a Unity "Force Binary" SerializedFile (format 22) in
+// either byte order. tests/fixtures/serialized_graph.asset is the same graph serialized as
+// YAML; serialized_parse.cmake checks that SNEngine_Novel_Counter reports all three alike.
+//
+//   serialized_fixture <out.asset> le|be
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t kAlignFlag = 0x4000;
+const uint32_t kFormatVersion = 22;
+const size_t kHeaderSize = 48;
+const int64_t kMainObject = 11400000;
+
+// Mirrors the reader in serialized_file.hpp: values are written in host (little-endian)
+// order and swapped when the file is big-endian.
+struct Writer {
+    template <typename T> void put(T v) {
+        unsigned char b[sizeof(T)];
+        std::memcpy(b, &v, sizeof(T));
+        if (big) std::reverse(b, b + sizeof(T));
+        out.append(reinterpret_cast<const char*>(b), sizeof(T));
+    }
+    void cstr(const std::string& s) {
+        out += s;
+        out += '\0';
+    }
+    // A string field: length, bytes, then the alignment its Array child asks for.
+    void str(const std::string& s) {
+        put<int32_t>(static_cast<int32_t>(s.size()));
+        out += s;
+        align();
+    }
+    void pptr(int32_t file_id, int64_t path_id) {
+        put<int32_t>(file_id);
+        put<int64_t>(path_id);
+    }
+    void align(size_t to = 4) {
+        while (out.size() % to) out += '\0';
+    }
+    bool big = false;
+    std::string out;
+};
+
+struct TypeTree {
+    struct Node {
+        uint8_t level;
+        uint8_t flags;
+        std::string type;
+        std::string name;
+        int32_t byte_size;
+        uint32_t meta_flag;
+    };
+
+    void add(int level, const std::string& type, const std::string& name, int32_t byte_size, uint32_t meta_flag = 0, uint8_t flags = 0) {
+        nodes.push_back({static_cast<uint8_t>(level), flags, type, name, byte_size, meta_flag});
+    }
+    void pptr(int level, const std::string& target, const std::string& name) {
+        add(level, "PPtr<" + target + ">", name, 12);
+        add(level + 1, "int", "m_FileID", 4);
+        add(level + 1, "SInt64", "m_PathID", 8);
+    }
+    void string(int level, const std::string& name) {
+        add(level, "string", name, -1);
+        add(level + 1, "Array", "Array", -1, kAlignFlag, 1);
+        add(level + 2, "int", "size", 4);
+        add(level + 2, "char", "data", 1);
+    }
+    // The element type follows at level + 2, named "data".
+    void vector(int level, const std::string& name) {
+        add(level, "vector", name, -1);
+        add(level + 1, "Array", "Array", -1, 0, 1);
+        add(level + 2, "int", "size", 4);
+    }
+    void vector2(int level, const std::string& name) {
+        add(level, "Vector2f", name, 8);
+        add(level + 1, "float", "x", 4);
+        add(level + 1, "float", "y", 4);
+    }
+
+    std::vector<Node> nodes;
+};
+
+enum Script { kGraphScript = 1, kStartScript, kDialogueScript, kWaitScript, kChoiceScript, kEndScript, kAliceAsset };
+
+struct External {
+    std::string guid;
+    std::string path;
+};
+
+// Indexed by PPtr m_FileID - 1.
+const External kExternals[] = {
+    {"9aa00000000000000000000000000001", "Assets/Scripts/DialogueGraph.cs"},
+    {"5ad00000000000000000000000000001", "Assets/Scripts/StartNode.cs"},
+    {"d1a00000000000000000000000000001", "Assets/Scripts/DialogueNode.cs"},
+    {"3a170000000000000000000000000001", "Assets/Scripts/WaitNode.cs"},
+    {"c4000000000000000000000000000001", "Assets/Scripts/ChoiceNode.cs"},
+    {"e4d00000000000000000000000000001", "Assets/Scripts/EndNode.cs"},
+    {"aaaa0000000000000000000000000001", "Assets/Characters/Alice.asset"},
+};
+
+TypeTree mono_behaviour() {
+    TypeTree t;
+    t.add(0, "MonoBehaviour", "Base", -1);
+    t.pptr(1, "GameObject", "m_GameObject");
+    t.add(1, "UInt8", "m_Enabled", 1, kAlignFlag);
+    t.add(1, "int", "m_EditorHideFlags", 4);
+    t.pptr(1, "MonoScript", "m_Script");
+    t.string(1, "m_Name");
+    t.string(1, "m_EditorClassIdentifier");
+    return t;
+}
+
+TypeTree graph_type() {
+    TypeTree t = mono_behaviour();
+    t.vector(1, "nodes");
+    t.pptr(3, "Node", "data");
+    return t;
+}
+
+TypeTree node_type(Script script) {
+    TypeTree t = mono_behaviour();
+    t.pptr(1, "NodeGraph", "graph");
+    t.vector2(1, "position");
+    t.add(1, "NodePortDictionary", "ports", -1);
+    t.vector(2, "keys");
+    t.string(4, "data");
+    t.vector(2, "values");
+    t.add(4, "NodePort", "data", -1);
+    t.string(5, "_fieldName");
+    t.pptr(5, "Node", "_node");
+    t.string(5, "_typeQualifiedName");
+    t.vector(5, "connections");
+    t.add(7, "PortConnection", "data", -1);
+    t.string(8, "fieldName");
+    t.pptr(8, "Node", "node");
+    t.vector(8, "reroutePoints");
+    t.vector2(10, "data");
+    t.add(5, "int", "_direction", 4);
+    t.add(5, "int", "_connectionType", 4);
+    t.add(5, "int", "_typeConstraint", 4);
+    t.add(5, "bool", "_dynamic", 1, kAlignFlag);
+    if (script == kDialogueScript) {
+        t.pptr(1, "CharacterBase", "_character");
+        t.string(1, "_text");
+    } else if (script == kWaitScript) {
+        t.add(1, "float", "_seconds", 4);
+    } else if (script == kChoiceScript) {
+        t.vector(1, "_variants");
+        t.string(3, "data");
+    }
+    return t;
+}
+
+struct Port {
+    std::string name;
+    int32_t direction;
+    std::vector<int64_t> links;
+};
+
+struct Object {
+    int64_t path_id;
+    Script script;
+    std::string data;
+};
+
+class GraphWriter {
+public:
+    explicit GraphWriter(bool big) : big_(big) {}
+
+    void graph(const std::string& name, const std::vector<int64_t>& nodes) {
+        Writer w = base(kGraphScript, name);
+        w.put<int32_t>(static_cast<int32_t>(nodes.size()));
+        for (int64_t node : nodes) w.pptr(0, node);
+        objects_.push_back({kMainObject, kGraphScript, w.out});
+    }
+
+    Writer node(int64_t self, Script script, const std::string& name, const std::vector<Port>& ports) {
+        Writer w = base(script, name);
+        w.pptr(0, kMainObject);
+        w.put<float>(0.0f);
+        w.put<float>(0.0f);
+        w.put<int32_t>(static_cast<int32_t>(ports.size()));
+        for (const auto& port : ports) w.str(port.name);
+        w.put<int32_t>(static_cast<int32_t>(ports.size()));
+        for (const auto& port : ports) {
+            w.str(port.name);
+            w.pptr(0, self);
+            w.str("SNEngine.Graphs.Node, Assembly-CSharp");
+            w.put<int32_t>(static_cast<int32_t>(port.links.size()));
+            for (int64_t link : port.links) {
+                w.str("_enter");
+                w.pptr(0, link);
+                w.put<int32_t>(0);
+            }
+            w.put<int32_t>(port.direction);
+            w.put<int32_t>(0);
+            w.put<int32_t>(0);
+            w.put<uint8_t>(0);
+            w.align();
+        }
+        return w;
+    }
+
+    void add(int64_t self, Script script, const Writer& w) { objects_.push_back({self, script, w.out}); }
+
+    std::string file() const {
+        std::vector<Script> scripts;
+        for (const auto& o : objects_) {
+            if (std::find(scripts.begin(), scripts.end(), o.script) == scripts.end()) scripts.push_back(o.script);
+        }
+
+        Writer data;
+        data.big = big_;
+        std::vector<std::pair<uint64_t, uint32_t>> placement;
+        for (const auto& o : objects_) {
+            data.align(8);
+            placement.push_back({data.out.size(), static_cast<uint32_t>(o.data.size())});
+            data.out += o.data;
+        }
+
+        // Alignment inside the metadata is relative to the start of the file.
+        Writer meta;
+        meta.big = big_;
+        meta.out.assign(kHeaderSize, '\0');
+        meta.cstr("2022.3.0f1");
+        meta.put<int32_t>(19);
+        meta.put<uint8_t>(1);
+        meta.put<int32_t>(static_cast<int32_t>(scripts.size()));
+        for (Script script : scripts) {
+            TypeTree t = script == kGraphScript ? graph_type() : node_type(script);
+            meta.put<int32_t>(114);
+            meta.put<uint8_t>(0);
+            meta.put<int16_t>(-1);
+            meta.out.append(32, '\0');
+            std::string strings;
+            Writer nodes;
+            nodes.big = big_;
+            for (size_t i = 0; i < t.nodes.size(); ++i) {
+                const auto& n = t.nodes[i];
+                nodes.put<uint16_t>(1);
+                nodes.put<uint8_t>(n.level);
+                nodes.put<uint8_t>(n.flags);
+                nodes.put<uint32_t>(static_cast<uint32_t>(strings.size()));
+                strings += n.type + '\0';
+                nodes.put<uint32_t>(static_cast<uint32_t>(strings.size()));
+                strings += n.name + '\0';
+                nodes.put<int32_t>(n.byte_size);
+                nodes.put<int32_t>(static_cast<int32_t>(i));
+                nodes.put<uint32_t>(n.meta_flag);
+                nodes.put<uint64_t>(0);
+            }
+            meta.put<int32_t>(static_cast<int32_t>(t.nodes.size()));
+            meta.put<int32_t>(static_cast<int32_t>(strings.size()));
+            meta.out += nodes.out;
+            meta.out += strings;
+            meta.put<int32_t>(0);
+        }
+        meta.put<int32_t>(static_cast<int32_t>(objects_.size()));
+        for (size_t i = 0; i < objects_.size(); ++i) {
+            meta.align();
+            meta.put<int64_t>(objects_[i].path_id);
+            meta.put<uint64_t>(placement[i].first);
+            meta.put<uint32_t>(placement[i].second);
+            meta.put<int32_t>(static_cast<int32_t>(std::find(scripts.begin(), scripts.end(), objects_[i].script) - scripts.begin()));
+        }
+        meta.put<int32_t>(0);
+        meta.put<int32_t>(static_cast<int32_t>(sizeof(kExternals) / sizeof(kExternals[0])));
+        for (const auto& e : kExternals) {
+            meta.cstr("");
+            for (int i = 0; i < 16; ++i) {
+                uint8_t lo = static_cast<uint8_t>(std::stoi(e.guid.substr(i * 2, 1), nullptr, 16));
+                uint8_t hi = static_cast<uint8_t>(std::stoi(e.guid.substr(i * 2 + 1, 1), nullptr, 16));
+                meta.put<uint8_t>(static_cast<uint8_t>((hi << 4) | lo));
+            }
+            meta.put<int32_t>(0);
+            meta.cstr(e.path);
+        }
+        meta.put<int32_t>(0);
+        meta.cstr("");
+        meta.align(16);
+
+        const uint64_t data_offset = meta.out.size();
+        const uint64_t file_size = data_offset + data.out.size();
+        Writer header;
+        header.big = true;
+        header.put<uint32_t>(0);
+        header.put<uint32_t>(0);
+        header.put<uint32_t>(kFormatVersion);
+        header.put<uint32_t>(0);
+        header.put<uint8_t>(big_ ? 1 : 0);
+        header.out.append(3, '\0');
+        header.put<uint32_t>(static_cast<uint32_t>(data_offset - kHeaderSize));
+        header.put<uint64_t>(file_size);
+        header.put<uint64_t>(data_offset);
+        header.put<uint64_t>(0);
+        return header.out + meta.out.substr(kHeaderSize) + data.out;
+    }
+
+private:
+    Writer base(Script script, const std::string& name) const {
+        Writer w;
+        w.big = big_;
+        w.pptr(0, 0);
+        w.put<uint8_t>(1);
+        w.align();
+        w.put<int32_t>(0);
+        w.pptr(script, 11500000);
+        w.str(name);
+        w.str("");
+        return w;
+    }
+
+    bool big_;
+    std::vector<Object> objects_;
+};
+
+std::string dialogue_graph(bool big) {
+    GraphWriter g(big);
+    g.graph("Fixture", {100, 101, 102, 103, 104, 105, 106});
+
+    g.add(100, kStartScript, g.node(100, kStartScript, "Start", {{"_exit", 1, {101}}}));
+
+    Writer hello = g.node(101, kDialogueScript, "Dialogue", {{"_enter", 0, {}}, {"_exit", 1, {102}}});
+    hello.pptr(kAliceAsset, kMainObject);
+    hello.str("Hello, <b>{playerName}</b>. Welcome home!");
+    g.add(101, kDialogueScript, hello);
+
+    Writer wait = g.node(102, kWaitScript, "Wait", {{"_enter", 0, {}}, {"_exit", 1, {103}}});
+    wait.put<float>(2.5f);
+    g.add(102, kWaitScript, wait);
+
+    Writer choice = g.node(103, kChoiceScript, "Choice", {{"_enter", 0, {}}, {"_exit", 1, {104, 105}}});
+    choice.put<int32_t>(2);
+    choice.str("Ask about the letter.");
+    choice.str("Stay silent.");
+    g.add(103, kChoiceScript, choice);
+
+    // Non-ASCII text must be measured in code points, as the YAML \u escapes are.
+    Writer ask = g.node(104, kDialogueScript, "Dialogue", {{"_enter", 0, {}}, {"_exit", 1, {106}}});
+    ask.pptr(kAliceAsset, kMainObject);
+    ask.str("\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82! \xd0\x9a\xd0\xb0\xd0\xba \xd0\xb4\xd0\xb5\xd0\xbb\xd0\xb0?");
+    g.add(104, kDialogueScript, ask);
+
+    Writer silent = g.node(105, kDialogueScript, "Dialogue", {{"_enter", 0, {}}, {"_exit", 1, {106}}});
+    silent.pptr(0, 0);
+    silent.str("Goodbye... See you soon.");
+    g.add(105, kDialogueScript, silent);
+
+    g.add(106, kEndScript, g.node(106, kEndScript, "End", {{"_enter", 0, {}}}));
+    return g.file();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3 || (std::string(argv[2]) != "le" && std::string(argv[2]) != "be")) {
+        std::cerr << "Usage: " << argv[0] << " <out.asset> le|be\n";
+        return 1;
+    }
+    std::ofstream out(argv[1], std::ios::binary);
+    out << dialogue_graph(std::string(argv[2]) == "be");
+    if (!out) {
+        std::cerr << "Could not write " << argv[1] << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+# Checks the binary SerializedFile reader of SNEngine_Novel_Counter against the YAML parser:
+# the same dialogue graph is written as YAML (tests/fixtures/serialized_graph.asset) and as
+# Force Binary in both byte orders by serialized_fixture, and all three JSON reports must be
+# identical.
+#
+#   cmake -DCOUNTER=<SNEngine_Novel_Counter> -DFIXTURE=<serialized_fixture> -DYAML=<serialized_graph.asset> -DWORK=<dir> -P serialized_parse.cmake
+
+file(REMOVE_RECURSE "${WORK}")
+foreach(mode yaml le be)
+    set(project "${WORK}/${mode}")
+    file(MAKE_DIRECTORY "${project}/Assets/Dialogues" "${project}/Assets/Characters")
+    file(WRITE "${project}/Assets/Characters/Alice.asset"
+        "%YAML 1.1\n%TAG !u! tag:unity3d.com,2011:\n--- !u!114 &11400000\nMonoBehaviour:\n"
+        "  m_Script: {fileID: 11500000, guid: cccc0000000000000000000000000001, type: 3}\n  m_Name: Alice\n")
+    file(WRITE "${project}/Assets/Characters/Alice.asset.meta"
+        "fileFormatVersion: 2\nguid: aaaa0000000000000000000000000001\nNativeFormatImporter:\n  mainObjectFileID: 11400000\n")
+    if(mode STREQUAL "yaml")
+        configure_file("${YAML}" "${project}/Assets/Dialogues/Fixture.asset" COPYONLY)
+    else()
+        execute_process(COMMAND "${FIXTURE}" "${project}/Assets/Dialogues/Fixture.asset" ${mode} RESULT_VARIABLE result)
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "serialized_fixture (${mode}) failed: ${result}")
+        endif()
+    endif()
+    execute_process(COMMAND "${COUNTER}" "${project}" --no-cache --guid-index "${project}/guids.bin" --json "${WORK}/${mode}.json"
+                    OUTPUT_QUIET ERROR_VARIABLE errors RESULT_VARIABLE result)
+    if(NOT result EQUAL 0 OR errors)
+        message(FATAL_ERROR "SNEngine_Novel_Counter (${mode}) failed: ${result}\n${errors}")
+    endif()
+endforeach()
+
+foreach(mode le be)
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${WORK}/${mode}.json" "${WORK}/yaml.json" RESULT_VARIABLE differ)
+    if(differ)
+        message(FATAL_ERROR "Binary (${mode}) and YAML parses differ: ${WORK}/${mode}.json vs ${WORK}/yaml.json")
+    endif()
+endforeach()
+file(READ "${WORK}/yaml.json" report)
+if(NOT report MATCHES "\"nodes\": 8," OR NOT report MATCHES "\"name\": \"Alice\", \"lines\": 2,")
+    message(FATAL_ERROR "Unexpected report in ${WORK}/yaml.json")
+endif()
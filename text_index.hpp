@@ -0,0 +1,353 @@
+#pragma once
+
+// Inverted full-text index over dialogue lines.
+//
+// The file is one 8-byte-aligned image used in place after mmap: a header, a graph
+// table, a document table (one document per text block: graph, node fileID and the
+// text itself), a term dictionary sorted by term bytes, varint delta-encoded posting
+// lists and a shared string blob. Terms are case-folded for ASCII and Cyrillic.
+// The header carries a hash of the indexed graph set, which tells a caller whether the
+// index is current, and a checksum of everything after it.
+
+#include "mapped_file.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+namespace snengine {
+
+struct TextIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t graph_count;
+    uint32_t doc_count;
+    uint32_t term_count;
+    uint64_t graphs_offset;
+    uint64_t docs_offset;
+    uint64_t terms_offset;
+    uint64_t postings_offset;
+    uint64_t strings_offset;
+    uint64_t total_size;
+    uint64_t content_hash;
+    uint64_t checksum;
+};
+static_assert(sizeof(TextIndexHeader) == 88, "TextIndexHeader is part of the on-disk format");
+
+const uint32_t kTextIndexVersion = 2;
+
+struct TextIndexGraph {
+    uint64_t path_offset;
+    uint32_t path_length;
+    uint32_t reserved;
+};
+
+struct TextIndexDoc {
+    int64_t file_id;
+    uint64_t text_offset;
+    uint32_t text_length;
+    uint32_t graph;
+};
+
+struct TextIndexTerm {
+    uint64_t term_offset;
+    uint64_t postings_offset;
+    uint32_t term_length;
+    uint32_t doc_count;
+};
+
+// Lower-cases ASCII and the two-byte Cyrillic block (А-Я, Ё) in UTF-8 text.
+inline std::string fold_case(std::string_view text) {
+    std::string out(text);
+    for (size_t i = 0; i < out.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(out[i]);
+        if (c >= 'A' && c <= 'Z') {
+            out[i] = static_cast<char>(c + 32);
+        } else if ((c == 0xD0) && i + 1 < out.size()) {
+            unsigned char d = static_cast<unsigned char>(out[i + 1]);
+            if (d >= 0x90 && d <= 0x9F) {
+                out[i + 1] = static_cast<char>(d + 0x20);
+            } else if (d >= 0xA0 && d <= 0xAF) {
+                out[i] = static_cast<char>(0xD1);
+                out[i + 1] = static_cast<char>(d - 0x20);
+            } else if (d == 0x81) {
+                out[i] = static_cast<char>(0xD1);
+                out[i + 1] = static_cast<char>(0x91);
+            }
+            ++i;
+        }
+    }
+    return out;
+}
+
+// Tokens are maximal runs of ASCII letters/digits and non-ASCII UTF-8 bytes.
+template <typename Fn>
+void for_each_token(std::string_view folded, Fn fn) {
+    size_t start = std::string_view::npos;
+    for (size_t i = 0; i <= folded.size(); ++i) {
+        unsigned char c = i < folded.size() ? static_cast<unsigned char>(folded[i]) : ' ';
+        bool word = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80;
+        if (word && start == std::string_view::npos) start = i;
+        if (!word && start != std::string_view::npos) {
+            fn(folded.substr(start, i - start));
+            start = std::string_view::npos;
+        }
+    }
+}
+
+inline void put_varint(std::string& out, uint32_t v) {
+    while (v >= 0x80) {
+        out += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+class TextIndexBuilder {
+public:
+    uint32_t add_graph(const std::string& path) {
+        graphs_.push_back(path);
+        return static_cast<uint32_t>(graphs_.size() - 1);
+    }
+
+    void add_text(uint32_t graph, int64_t file_id, const std::string& text) {
+        uint32_t doc = static_cast<uint32_t>(docs_.size());
+        docs_.push_back({graph, file_id, text});
+        for_each_token(fold_case(text), [&](std::string_view token) {
+            std::vector<uint32_t>& list = postings_[std::string(token)];
+            if (list.empty() || list.back() != doc) list.push_back(doc);
+        });
+    }
+
+    // `content_hash` identifies the indexed graph set; see TextIndex::stored_hash.
+    // Leaves `file` untouched (and sets `*unchanged`) when it already holds this exact index.
+    bool write(const std::string& file, uint64_t content_hash, bool* unchanged = nullptr) const {
+        std::vector<const std::pair<const std::string, std::vector<uint32_t>>*> terms;
+        terms.reserve(postings_.size());
+        for (const auto& kv : postings_) terms.push_back(&kv);
+        std::sort(terms.begin(), terms.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+        std::string strings, postings;
+        std::vector<TextIndexGraph> graph_table;
+        for (const auto& g : graphs_) {
+            graph_table.push_back({strings.size(), static_cast<uint32_t>(g.size()), 0});
+            strings += g;
+        }
+        std::vector<TextIndexDoc> doc_table;
+        for (const auto& d : docs_) {
+            doc_table.push_back({d.file_id, strings.size(), static_cast<uint32_t>(d.text.size()), d.graph});
+            strings += d.text;
+        }
+        std::vector<TextIndexTerm> term_table;
+        for (const auto* t : terms) {
+            term_table.push_back({strings.size(), postings.size(), static_cast<uint32_t>(t->first.size()),
+                                  static_cast<uint32_t>(t->second.size())});
+            strings += t->first;
+            uint32_t prev = 0;
+            for (uint32_t doc : t->second) {
+                put_varint(postings, doc - prev);
+                prev = doc;
+            }
+        }
+
+        TextIndexHeader h{};
+        std::memcpy(h.magic, "SNTXIDX1", 8);
+        h.version = kTextIndexVersion;
+        h.graph_count = static_cast<uint32_t>(graph_table.size());
+        h.doc_count = static_cast<uint32_t>(doc_table.size());
+        h.term_count = static_cast<uint32_t>(term_table.size());
+        h.graphs_offset = sizeof(TextIndexHeader);
+        h.docs_offset = h.graphs_offset + graph_table.size() * sizeof(TextIndexGraph);
+        h.terms_offset = h.docs_offset + doc_table.size() * sizeof(TextIndexDoc);
+        h.postings_offset = h.terms_offset + term_table.size() * sizeof(TextIndexTerm);
+        h.strings_offset = (h.postings_offset + postings.size() + 7) & ~uint64_t(7);
+        h.total_size = h.strings_offset + strings.size();
+        h.content_hash = content_hash;
+
+        std::string image;
+        image.reserve(h.total_size);
+        image.append(reinterpret_cast<const char*>(&h), sizeof(h));
+        image.append(reinterpret_cast<const char*>(graph_table.data()), graph_table.size() * sizeof(TextIndexGraph));
+        image.append(reinterpret_cast<const char*>(doc_table.data()), doc_table.size() * sizeof(TextIndexDoc));
+        image.append(reinterpret_cast<const char*>(term_table.data()), term_table.size() * sizeof(TextIndexTerm));
+        image += postings;
+        image.resize(h.strings_offset, '\0');
+        image += strings;
+        h.checksum = image_checksum(image.data() + sizeof(h), image.size() - sizeof(h));
+        std::memcpy(&image[0], &h, sizeof(h));
+
+        MappedFile current;
+        bool same = current.open(file) && current.size() == image.size() &&
+                    std::memcmp(current.data(), image.data(), image.size()) == 0;
+        current.close();
+        if (unchanged) *unchanged = same;
+        if (same) return true;
+
+        std::string tmp = file + ".tmp";
+        FILE* f = std::fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+        bool ok = std::fwrite(image.data(), 1, image.size(), f) == image.size();
+        ok = (std::fclose(f) == 0) && ok;
+        if (ok) {
+#ifdef _WIN32
+            std::remove(file.c_str());
+#endif
+            ok = std::rename(tmp.c_str(), file.c_str()) == 0;
+        }
+        if (!ok) std::remove(tmp.c_str());
+        return ok;
+    }
+
+    size_t doc_count() const { return docs_.size(); }
+    size_t term_count() const { return postings_.size(); }
+
+private:
+    struct Doc {
+        uint32_t graph;
+        int64_t file_id;
+        std::string text;
+    };
+    std::vector<std::string> graphs_;
+    std::vector<Doc> docs_;
+    std::unordered_map<std::string, std::vector<uint32_t>> postings_;
+};
+
+class TextIndex {
+public:
+    // The content hash a valid-looking index header was written with; reads the header only.
+    static bool stored_hash(const std::string& file, uint64_t& hash) {
+        TextIndexHeader h;
+        FILE* f = std::fopen(file.c_str(), "rb");
+        if (!f) return false;
+        bool ok = std::fread(&h, 1, sizeof(h), f) == sizeof(h);
+        std::fclose(f);
+        if (!ok || std::memcmp(h.magic, "SNTXIDX1", 8) != 0 || h.version != kTextIndexVersion) return false;
+        hash = h.content_hash;
+        return true;
+    }
+
+    // Returns false (leaving the index closed) if the file is missing, truncated or corrupt.
+    bool load(const std::string& file) {
+        if (!file_.open(file)) return false;
+        if (!valid()) {
+            file_.close();
+            return false;
+        }
+        return true;
+    }
+
+    size_t doc_count() const { return header().doc_count; }
+    const TextIndexDoc& doc(uint32_t i) const { return docs()[i]; }
+    std::string_view text(const TextIndexDoc& d) const { return str(d.text_offset, d.text_length); }
+    std::string_view graph_path(const TextIndexDoc& d) const {
+        if (d.graph >= header().graph_count) return {};
+        const TextIndexGraph& g = reinterpret_cast<const TextIndexGraph*>(file_.data() + header().graphs_offset)[d.graph];
+        return str(g.path_offset, g.path_length);
+    }
+
+    // Documents containing every token of `query`. With `phrase` set, the folded query
+    // must also occur verbatim in the folded text.
+    std::vector<uint32_t> search(const std::string& query, bool phrase) const {
+        std::string folded = fold_case(query);
+        std::vector<std::string_view> tokens;
+        for_each_token(folded, [&](std::string_view t) { tokens.push_back(t); });
+        if (tokens.empty()) return {};
+        std::vector<const TextIndexTerm*> terms;
+        for (auto t : tokens) {
+            const TextIndexTerm* term = find(t);
+            if (!term) return {};
+            terms.push_back(term);
+        }
+        std::sort(terms.begin(), terms.end(), [](const TextIndexTerm* a, const TextIndexTerm* b) {
+            return a->doc_count < b->doc_count;
+        });
+        std::vector<uint32_t> result = decode(*terms[0]);
+        for (size_t i = 1; i < terms.size() && !result.empty(); ++i) {
+            std::vector<uint32_t> other = decode(*terms[i]), merged;
+            std::set_intersection(result.begin(), result.end(), other.begin(), other.end(), std::back_inserter(merged));
+            result.swap(merged);
+        }
+        if (phrase) {
+            result.erase(std::remove_if(result.begin(), result.end(), [&](uint32_t d) {
+                return fold_case(text(doc(d))).find(folded) == std::string::npos;
+            }), result.end());
+        }
+        return result;
+    }
+
+private:
+    const TextIndexHeader& header() const { return *reinterpret_cast<const TextIndexHeader*>(file_.data()); }
+    const TextIndexDoc* docs() const { return reinterpret_cast<const TextIndexDoc*>(file_.data() + header().docs_offset); }
+    const TextIndexTerm* terms_begin() const { return reinterpret_cast<const TextIndexTerm*>(file_.data() + header().terms_offset); }
+    // Table entries are checked as they are used; an out-of-range string reads as empty.
+    std::string_view str(uint64_t offset, uint32_t length) const {
+        const uint64_t string_bytes = file_.size() - header().strings_offset;
+        if (offset > string_bytes || length > string_bytes - offset) return {};
+        return std::string_view(file_.data() + header().strings_offset + offset, length);
+    }
+
+    const TextIndexTerm* find(std::string_view token) const {
+        const TextIndexTerm* begin = terms_begin();
+        const TextIndexTerm* end = begin + header().term_count;
+        const TextIndexTerm* it = std::lower_bound(begin, end, token, [&](const TextIndexTerm& t, std::string_view key) {
+            return str(t.term_offset, t.term_length) < key;
+        });
+        return (it != end && str(it->term_offset, it->term_length) == token) ? it : nullptr;
+    }
+
+    // Checks the header, the section layout and the checksum; entries and posting lists
+    // are bounds-checked lazily by str() and decode(), so opening is one sequential pass.
+    bool valid() const {
+        const char* data = file_.data();
+        const uint64_t size = file_.size();
+        if (!data || size < sizeof(TextIndexHeader) || (reinterpret_cast<uintptr_t>(data) & 7)) return false;
+        const TextIndexHeader& h = header();
+        if (std::memcmp(h.magic, "SNTXIDX1", 8) != 0 || h.version != kTextIndexVersion || h.total_size != size) return false;
+        auto section = [&](uint64_t offset, uint64_t bytes, uint64_t next) {
+            return offset % 8 == 0 && offset <= next && bytes <= next - offset && next <= size;
+        };
+        if (h.graphs_offset < sizeof(TextIndexHeader) ||
+            !section(h.graphs_offset, uint64_t(h.graph_count) * sizeof(TextIndexGraph), h.docs_offset) ||
+            !section(h.docs_offset, uint64_t(h.doc_count) * sizeof(TextIndexDoc), h.terms_offset) ||
+            !section(h.terms_offset, uint64_t(h.term_count) * sizeof(TextIndexTerm), h.postings_offset) ||
+            h.postings_offset > h.strings_offset || !section(h.strings_offset, 0, size)) {
+            return false;
+        }
+        return image_checksum(data + sizeof(TextIndexHeader), size - sizeof(TextIndexHeader)) == h.checksum;
+    }
+
+    // A posting list that runs past its section, overflows or leaves the document range
+    // is treated as empty.
+    std::vector<uint32_t> decode(const TextIndexTerm& term) const {
+        const TextIndexHeader& h = header();
+        const uint64_t posting_bytes = h.strings_offset - h.postings_offset;
+        if (term.postings_offset > posting_bytes || term.doc_count > h.doc_count) return {};
+        std::vector<uint32_t> docs;
+        docs.reserve(term.doc_count);
+        const unsigned char* postings = reinterpret_cast<const unsigned char*>(file_.data() + h.postings_offset);
+        uint64_t pos = term.postings_offset;
+        uint64_t doc = 0;
+        for (uint32_t i = 0; i < term.doc_count; ++i) {
+            uint32_t v = 0;
+            int shift = 0;
+            do {
+                if (pos >= posting_bytes || shift > 28) return {};
+                v |= static_cast<uint32_t>(postings[pos] & 0x7F) << shift;
+                shift += 7;
+            } while (postings[pos++] & 0x80);
+            doc += v;
+            if (doc >= h.doc_count || (i > 0 && v == 0)) return {};
+            docs.push_back(static_cast<uint32_t>(doc));
+        }
+        return docs;
+    }
+
+    MappedFile file_;
+};
+
+}